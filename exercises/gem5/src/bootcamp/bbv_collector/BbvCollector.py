@@ -0,0 +1,25 @@
+from m5.objects.Probe import ProbeListenerObject
+from m5.params import *
+
+class BbvCollector(ProbeListenerObject):
+    """
+    Collects basic block vectors for SimPoint like the stock SimPoint probe,
+    but writes them as a compressed binary stream. Convert the stream with
+    materials/04-Advanced-using-gem5/09-sampling/01-simpoint/bbv-to-simpoint.py.
+
+    Attach it to a simple (e.g. atomic) CPU, whose Commit probe it listens
+    to: cpu.bbv_collector = BbvCollector(manager=cpu, interval=1000000)
+    """
+    type = "BbvCollector"
+    cxx_header = "bootcamp/bbv_collector/bbv_collector.hh"
+    cxx_class = "gem5::BbvCollector"
+
+    interval = Param.UInt64(100000000, "Instructions in each interval.")
+    output = Param.String(
+        "bbv.bin.gz",
+        "File in the output directory to stream the vectors to. It is "
+        "compressed if it ends in .gz."
+    )
+    initial_table_size = Param.Unsigned(
+        4096, "Slots the basic block table starts with, a power of two."
+    )
@@ -0,0 +1,177 @@
+#include "bootcamp/bbv_collector/bbv_collector.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/trace.hh"
+#include "debug/BbvCollector.hh"
+#include "sim/sim_exit.hh"
+
+namespace gem5
+{
+
+BbvCollector::BbvCollector(const BbvCollectorParams& params):
+    ProbeListenerObject(params),
+    numBlocks(0),
+    intervalSize(params.interval),
+    intervalCount(0),
+    intervalDrift(0),
+    currentBBInstCount(0),
+    outputName(params.output),
+    output(nullptr)
+{
+    fatal_if(intervalSize == 0, "%s: interval has to be above 0.", name());
+    fatal_if(params.initial_table_size == 0 ||
+             (params.initial_table_size & (params.initial_table_size - 1)) != 0,
+             "%s: initial_table_size has to be a power of two.", name());
+    table.resize(params.initial_table_size, Slot{0, 0, 0, 0});
+}
+
+void
+BbvCollector::init()
+{
+    output = simout.create(outputName, true);
+    buffer.insert(buffer.end(), BBV_MAGIC, BBV_MAGIC + std::strlen(BBV_MAGIC));
+    writeVarint(intervalSize);
+    // The last, partial interval is left out, as the stock SimPoint probe
+    // does, but what was written has to reach the file.
+    registerExitCallback([this]() { close(); });
+}
+
+void
+BbvCollector::regProbeListeners()
+{
+    typedef ProbeListenerArg<BbvCollector, std::pair<SimpleThread*, StaticInstPtr>> BbvListener;
+    listeners.push_back(new BbvListener(this, "Commit", &BbvCollector::profile));
+}
+
+size_t
+BbvCollector::hash(Addr start, Addr end)
+{
+    uint64_t key = start * 0x9e3779b97f4a7c15ULL ^ end;
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 32;
+    return key;
+}
+
+size_t
+BbvCollector::findSlot(Addr start, Addr end) const
+{
+    const size_t mask = table.size() - 1;
+    size_t i = hash(start, end) & mask;
+    while (table[i].id != 0 && (table[i].start != start || table[i].end != end)) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void
+BbvCollector::grow()
+{
+    std::vector<Slot> old_table(table.size() * 2, Slot{0, 0, 0, 0});
+    old_table.swap(table);
+    for (const Slot& slot: old_table) {
+        if (slot.id != 0) {
+            table[findSlot(slot.start, slot.end)] = slot;
+        }
+    }
+    // The touched slots moved, find them again.
+    for (auto& index: touched) {
+        const Slot& slot = old_table[index];
+        index = findSlot(slot.start, slot.end);
+    }
+    DPRINTF(BbvCollector, "%s: Grew the table to %d slots.\n", __func__, table.size());
+}
+
+void
+BbvCollector::countBlock()
+{
+    size_t i = findSlot(currentBB.first, currentBB.second);
+    if (table[i].id == 0) {
+        table[i] = Slot{currentBB.first, currentBB.second, (uint32_t) ++numBlocks, 0};
+    }
+    if (table[i].count == 0) {
+        touched.push_back(i);
+    }
+    table[i].count += currentBBInstCount;
+    // Keep the table at most half full so that probes stay short.
+    if (numBlocks * 2 > table.size()) {
+        grow();
+    }
+}
+
+void
+BbvCollector::writeVarint(uint64_t value)
+{
+    while (value >= 0x80) {
+        buffer.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(value);
+}
+
+void
+BbvCollector::writeInterval()
+{
+    std::sort(touched.begin(), touched.end(), [this](uint32_t a, uint32_t b) {
+        return table[a].id < table[b].id;
+    });
+    writeVarint(touched.size());
+    uint32_t previous_id = 0;
+    for (uint32_t index: touched) {
+        Slot& slot = table[index];
+        writeVarint(slot.id - previous_id);
+        writeVarint(slot.count);
+        previous_id = slot.id;
+        slot.count = 0;
+    }
+    DPRINTF(BbvCollector, "%s: Wrote an interval of %d basic blocks.\n", __func__, touched.size());
+    touched.clear();
+
+    output->stream()->write((const char*) buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void
+BbvCollector::close()
+{
+    if (output != nullptr) {
+        output->stream()->write((const char*) buffer.data(), buffer.size());
+        buffer.clear();
+        simout.close(output);
+        output = nullptr;
+    }
+}
+
+void
+BbvCollector::profile(const std::pair<SimpleThread*, StaticInstPtr>& p)
+{
+    SimpleThread* thread = p.first;
+    const StaticInstPtr& inst = p.second;
+
+    if (inst->isMicroop() && !inst->isLastMicroop()) {
+        return;
+    }
+
+    if (currentBBInstCount == 0) {
+        currentBB.first = thread->pcState().instAddr();
+    }
+    intervalCount++;
+    currentBBInstCount++;
+
+    // A control instruction ends the basic block.
+    if (inst->isControl()) {
+        currentBB.second = thread->pcState().instAddr();
+        countBlock();
+        currentBBInstCount = 0;
+
+        if (intervalCount + intervalDrift >= intervalSize) {
+            writeInterval();
+            intervalDrift = (intervalCount + intervalDrift) - intervalSize;
+            intervalCount = 0;
+        }
+    }
+}
+
+} // namespace gem5
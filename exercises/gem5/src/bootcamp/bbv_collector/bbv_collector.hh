@@ -0,0 +1,85 @@
+#ifndef __BOOTCAMP_BBV_COLLECTOR_BBV_COLLECTOR_HH__
+#define __BOOTCAMP_BBV_COLLECTOR_BBV_COLLECTOR_HH__
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/output.hh"
+#include "base/types.hh"
+#include "cpu/simple_thread.hh"
+#include "cpu/static_inst.hh"
+#include "params/BbvCollector.hh"
+#include "sim/probe/probe.hh"
+
+// Stream format, all numbers after the header are unsigned LEB128 varints:
+//
+//     "BBV1" interval
+//     for every interval:
+//         number of basic blocks N
+//         N times: id - previous id, instructions
+//
+// Ids count up from 1 in the order the blocks are first seen and are sorted
+// within an interval, so the deltas are small.
+#define BBV_MAGIC "BBV1"
+
+namespace gem5
+{
+
+class BbvCollector : public ProbeListenerObject
+{
+  private:
+    // A basic block is the range of PCs from its first to its last
+    // (control) instruction.
+    typedef std::pair<Addr, Addr> BasicBlockRange;
+
+    // One slot of the open addressing table. id 0 marks an empty slot.
+    struct Slot
+    {
+        Addr start;
+        Addr end;
+        uint32_t id;
+        // Instructions run in the block this interval.
+        uint64_t count;
+    };
+
+    std::vector<Slot> table;
+    size_t numBlocks;
+    // Slots with a count this interval, so writing an interval only looks at
+    // the blocks it ran.
+    std::vector<uint32_t> touched;
+
+    const uint64_t intervalSize;
+    uint64_t intervalCount;
+    // How far past intervalSize the last interval ran, since intervals only
+    // end at the end of a basic block.
+    uint64_t intervalDrift;
+
+    BasicBlockRange currentBB;
+    uint64_t currentBBInstCount;
+
+    std::string outputName;
+    OutputStream* output;
+    std::vector<uint8_t> buffer;
+
+    static size_t hash(Addr start, Addr end);
+    size_t findSlot(Addr start, Addr end) const;
+    void grow();
+    void countBlock();
+    void writeVarint(uint64_t value);
+    void writeInterval();
+    void close();
+
+  public:
+    BbvCollector(const BbvCollectorParams& params);
+
+    void init() override;
+    void regProbeListeners() override;
+
+    void profile(const std::pair<SimpleThread*, StaticInstPtr>& p);
+};
+
+} // namespace gem5
+
+#endif // __BOOTCAMP_BBV_COLLECTOR_BBV_COLLECTOR_HH__
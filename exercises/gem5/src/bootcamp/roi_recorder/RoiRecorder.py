@@ -0,0 +1,25 @@
+from m5.objects.SimObject import SimObject
+from m5.params import *
+from m5.util.pybind import PyBindMethod
+
+class RoiRecorder(SimObject):
+    type = "RoiRecorder"
+    cxx_header = "bootcamp/roi_recorder/roi_recorder.hh"
+    cxx_class = "gem5::RoiRecorder"
+
+    cxx_exports = [
+        PyBindMethod("workBegin"),
+        PyBindMethod("workEnd"),
+        PyBindMethod("flush"),
+    ]
+
+    stats = VectorParam.String(
+        "Full names of the scalar, vector or formula stats to record, "
+        "e.g. board.processor.cores0.core.numCycles."
+    )
+    output = Param.String(
+        "roi_stats.csv", "File in the output directory to write the regions to."
+    )
+    batch_size = Param.Unsigned(
+        4096, "Regions to keep in memory before writing them out."
+    )
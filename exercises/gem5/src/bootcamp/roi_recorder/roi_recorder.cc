@@ -0,0 +1,119 @@
+#include "bootcamp/roi_recorder/roi_recorder.hh"
+
+#include "base/trace.hh"
+#include "debug/RoiRecorder.hh"
+#include "sim/root.hh"
+#include "sim/sim_exit.hh"
+
+namespace gem5
+{
+
+RoiRecorder::RoiRecorder(const RoiRecorderParams& params):
+    SimObject(params),
+    statNames(params.stats),
+    outputName(params.output),
+    output(nullptr),
+    batchSize(params.batch_size)
+{
+    fatal_if(batchSize == 0, "%s: batch_size has to be at least 1.", name());
+    regions.reserve(batchSize);
+    deltas.reserve(batchSize * statNames.size());
+    registerExitCallback([this]() { flush(); });
+}
+
+void
+RoiRecorder::startup()
+{
+    for (const auto& stat_name: statNames) {
+        const statistics::Info* info = Root::root()->resolveStat(stat_name);
+        fatal_if(info == nullptr, "%s: There is no stat called %s.", name(), stat_name);
+        fatal_if(dynamic_cast<const statistics::ScalarInfo*>(info) == nullptr &&
+                 dynamic_cast<const statistics::VectorInfo*>(info) == nullptr,
+                 "%s: %s is not a scalar, vector or formula stat.", name(), stat_name);
+        statInfos.push_back(info);
+    }
+}
+
+void
+RoiRecorder::snapshot(std::vector<double>& values) const
+{
+    values.resize(statInfos.size());
+    for (size_t i = 0; i < statInfos.size(); i++) {
+        if (auto scalar = dynamic_cast<const statistics::ScalarInfo*>(statInfos[i])) {
+            values[i] = scalar->result();
+        } else {
+            values[i] = static_cast<const statistics::VectorInfo*>(statInfos[i])->total();
+        }
+    }
+}
+
+void
+RoiRecorder::workBegin(uint64_t workid)
+{
+    OpenRegion& region = openRegions[workid];
+    if (region.depth++ > 0) {
+        DPRINTF(RoiRecorder, "%s: Nested begin of workid %d, depth %d.\n", __func__, workid, region.depth);
+        return;
+    }
+    DPRINTF(RoiRecorder, "%s: Begin of workid %d.\n", __func__, workid);
+    region.beginTick = curTick();
+    snapshot(region.beginValues);
+}
+
+void
+RoiRecorder::workEnd(uint64_t workid)
+{
+    auto it = openRegions.find(workid);
+    if (it == openRegions.end()) {
+        warn("%s: End of workid %d without a begin, ignoring it.", name(), workid);
+        return;
+    }
+    OpenRegion& region = it->second;
+    if (--region.depth > 0) {
+        DPRINTF(RoiRecorder, "%s: Nested end of workid %d, depth %d.\n", __func__, workid, region.depth);
+        return;
+    }
+    DPRINTF(RoiRecorder, "%s: End of workid %d.\n", __func__, workid);
+
+    std::vector<double> end_values;
+    snapshot(end_values);
+    regions.push_back({workid, region.beginTick, curTick()});
+    for (size_t i = 0; i < end_values.size(); i++) {
+        deltas.push_back(end_values[i] - region.beginValues[i]);
+    }
+    openRegions.erase(it);
+
+    if (regions.size() >= batchSize) {
+        flush();
+    }
+}
+
+void
+RoiRecorder::flush()
+{
+    if (output == nullptr) {
+        output = simout.create(outputName);
+        std::ostream& os = *output->stream();
+        os << "workid,begin_tick,end_tick";
+        for (const auto& stat_name: statNames) {
+            os << "," << stat_name;
+        }
+        os << "\n";
+    }
+    DPRINTF(RoiRecorder, "%s: Writing %d regions.\n", __func__, regions.size());
+
+    std::ostream& os = *output->stream();
+    const size_t num_stats = statNames.size();
+    for (size_t r = 0; r < regions.size(); r++) {
+        os << regions[r].workid << "," << regions[r].beginTick << "," << regions[r].endTick;
+        for (size_t i = 0; i < num_stats; i++) {
+            os << "," << deltas[r * num_stats + i];
+        }
+        os << "\n";
+    }
+    os.flush();
+    regions.clear();
+    deltas.clear();
+}
+
+} // namespace gem5
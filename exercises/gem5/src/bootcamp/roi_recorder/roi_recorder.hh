@@ -0,0 +1,68 @@
+#ifndef __BOOTCAMP_ROI_RECORDER_ROI_RECORDER_HH__
+#define __BOOTCAMP_ROI_RECORDER_ROI_RECORDER_HH__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/output.hh"
+#include "base/statistics.hh"
+#include "params/RoiRecorder.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+// Records a few stats over every region of interest without dumping or
+// resetting the rest. workBegin/workEnd snapshot only the chosen stats into
+// memory, and the difference over each region is written out batch_size
+// regions at a time (and at the end of the simulation) as one CSV row:
+//
+//     workid,begin_tick,end_tick,<stat>,<stat>,...
+//
+// Regions with the same workid nest: only the outermost begin and end count.
+class RoiRecorder : public SimObject
+{
+  private:
+    std::vector<std::string> statNames;
+    // Resolved in startup(), once every stat has been registered.
+    std::vector<const statistics::Info*> statInfos;
+
+    std::string outputName;
+    OutputStream* output;
+    size_t batchSize;
+
+    struct OpenRegion
+    {
+        int depth;
+        Tick beginTick;
+        std::vector<double> beginValues;
+    };
+    std::unordered_map<uint64_t, OpenRegion> openRegions;
+
+    // Finished regions waiting to be written out, each a workid, its two
+    // ticks and the deltas of the stats, back to back.
+    struct Region
+    {
+        uint64_t workid;
+        Tick beginTick;
+        Tick endTick;
+    };
+    std::vector<Region> regions;
+    std::vector<double> deltas;
+
+    void snapshot(std::vector<double>& values) const;
+
+  public:
+    RoiRecorder(const RoiRecorderParams& params);
+    void startup() override;
+
+    void workBegin(uint64_t workid);
+    void workEnd(uint64_t workid);
+    // Writes the finished regions out now.
+    void flush();
+};
+
+} // namespace gem5
+
+#endif // __BOOTCAMP_ROI_RECORDER_ROI_RECORDER_HH__
@@ -0,0 +1,50 @@
+from m5.objects.SimObject import SimObject
+from m5.params import *
+from m5.util.pybind import PyBindMethod
+
+class SmartsController(SimObject):
+    """
+    Runs SMARTS style systematic sampling until the IPC estimate is good
+    enough. Every period of period * unit_size instructions is split into
+    functional warming on functional_cpu, detailed_warmup instructions of
+    detailed warming on detailed_cpu, and unit_size measured instructions on
+    detailed_cpu.
+
+    The controller schedules the end of each phase itself. Switching the
+    cores has to happen in Python, so at every
+    ExitEvent.SIMPOINT_BEGIN call nextPhase(), stop if done(), switch the
+    processor if the phase needs the other core, then call startPhase(). See
+    materials/04-Advanced-using-gem5/09-sampling/03-SMARTS/complete/SMARTS-controller.py.
+    """
+    type = "SmartsController"
+    cxx_header = "bootcamp/smarts_controller/smarts_controller.hh"
+    cxx_class = "gem5::SmartsController"
+
+    cxx_exports = [
+        PyBindMethod("nextPhase"),
+        PyBindMethod("startPhase"),
+        PyBindMethod("usesDetailedCPU"),
+        PyBindMethod("done"),
+    ]
+
+    functional_cpu = Param.BaseCPU("CPU that runs the functional warming.")
+    detailed_cpu = Param.BaseCPU("CPU that runs detailed warming and measures.")
+
+    period = Param.UInt64("Sampling period k, in sampling units.")
+    unit_size = Param.UInt64(1000, "Instructions measured in each sample, U.")
+    detailed_warmup = Param.UInt64(
+        2000, "Instructions of detailed warming before each sample, W."
+    )
+
+    confidence = Param.Float(
+        0.997, "Confidence of the interval around the mean IPC."
+    )
+    target_error = Param.Float(
+        0.03,
+        "Stop once the confidence interval is within this fraction of the "
+        "mean IPC.",
+    )
+    min_samples = Param.UInt64(
+        30, "Samples to take before checking the confidence interval."
+    )
+    max_samples = Param.UInt64(0, "Stop after this many samples, 0 for no limit.")
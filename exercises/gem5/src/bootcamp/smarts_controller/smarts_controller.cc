@@ -0,0 +1,172 @@
+#include "bootcamp/smarts_controller/smarts_controller.hh"
+
+#include <cmath>
+
+#include "base/trace.hh"
+#include "debug/SmartsController.hh"
+
+namespace gem5
+{
+
+SmartsController::SmartsController(const SmartsControllerParams& params):
+    SimObject(params),
+    functionalCPU(params.functional_cpu),
+    detailedCPU(params.detailed_cpu),
+    unitSize(params.unit_size),
+    detailedWarmup(params.detailed_warmup),
+    functionalLength(params.period * params.unit_size - params.unit_size - params.detailed_warmup),
+    targetError(params.target_error),
+    minSamples(params.min_samples),
+    maxSamples(params.max_samples),
+    z(normalQuantile(params.confidence)),
+    phase(FunctionalWarming),
+    sampleStartInsts(0),
+    sampleStartCycle(0),
+    numSamples(0),
+    mean(0),
+    m2(0),
+    stats(this)
+{
+    fatal_if(unitSize == 0, "%s: unit_size has to be above 0.", name());
+    fatal_if(params.period * unitSize <= unitSize + detailedWarmup,
+             "%s: The period has to be longer than the detailed warming and the sample.", name());
+    fatal_if(params.confidence <= 0 || params.confidence >= 1,
+             "%s: confidence has to be between 0 and 1.", name());
+    fatal_if(minSamples < 2, "%s: min_samples has to be at least 2 for a variance.", name());
+}
+
+SmartsController::SmartsControllerStats::SmartsControllerStats(SmartsController* controller):
+    statistics::Group(controller),
+    ADD_STAT(samples, statistics::units::Count::get(), "Number of samples measured."),
+    ADD_STAT(ipcMean, statistics::units::Rate<statistics::units::Count, statistics::units::Cycle>::get(),
+             "Mean IPC of the samples."),
+    ADD_STAT(ipcStdDev, statistics::units::Rate<statistics::units::Count, statistics::units::Cycle>::get(),
+             "Standard deviation of the IPC of the samples."),
+    ADD_STAT(relativeError, statistics::units::Ratio::get(),
+             "Half width of the confidence interval over the mean IPC."),
+    ADD_STAT(samplesNeeded, statistics::units::Count::get(),
+             "Samples needed for target_error at the current variance.")
+{}
+
+double
+SmartsController::normalQuantile(double confidence)
+{
+    // Solve erf(z / sqrt(2)) = confidence by bisection, erf is increasing.
+    double low = 0;
+    double high = 10;
+    for (int i = 0; i < 100; i++) {
+        double middle = (low + high) / 2;
+        if (std::erf(middle / std::sqrt(2.0)) < confidence) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return (low + high) / 2;
+}
+
+double
+SmartsController::relativeError() const
+{
+    if (numSamples < 2 || mean == 0) {
+        return INFINITY;
+    }
+    double variance = m2 / (numSamples - 1);
+    return z * std::sqrt(variance / numSamples) / mean;
+}
+
+void
+SmartsController::endSample()
+{
+    Counter insts = detailedCPU->totalInsts() - sampleStartInsts;
+    Cycles cycles = detailedCPU->curCycle() - sampleStartCycle;
+    double ipc = cycles == 0 ? 0 : (double) insts / cycles;
+
+    numSamples++;
+    double delta = ipc - mean;
+    mean += delta / numSamples;
+    m2 += delta * (ipc - mean);
+
+    double std_dev = numSamples > 1 ? std::sqrt(m2 / (numSamples - 1)) : 0;
+    double error = relativeError();
+    stats.samples = numSamples;
+    stats.ipcMean = mean;
+    stats.ipcStdDev = std_dev;
+    stats.relativeError = std::isfinite(error) ? error : 0;
+    if (mean != 0) {
+        // SMARTS' estimate of n for the target error: (z * V / e)^2, where V
+        // is the coefficient of variation.
+        double needed = z * std_dev / mean / targetError;
+        stats.samplesNeeded = std::ceil(needed * needed);
+    }
+    DPRINTF(SmartsController, "%s: Sample %d IPC %f, mean %f +- %f%%.\n",
+            __func__, numSamples, ipc, mean, error * 100);
+}
+
+int
+SmartsController::nextPhase()
+{
+    switch (phase) {
+      case FunctionalWarming:
+        phase = DetailedWarming;
+        break;
+      case DetailedWarming:
+        phase = Measurement;
+        break;
+      case Measurement:
+        endSample();
+        if ((numSamples >= minSamples && relativeError() <= targetError) ||
+            (maxSamples != 0 && numSamples >= maxSamples)) {
+            inform("%s: Mean IPC %f +- %f%% after %d samples.", name(), mean,
+                   relativeError() * 100, numSamples);
+            phase = Done;
+        } else {
+            phase = FunctionalWarming;
+        }
+        break;
+      case Done:
+        break;
+    }
+    return phase;
+}
+
+void
+SmartsController::scheduleStop(BaseCPU* cpu, uint64_t insts)
+{
+    // The exit cause the stdlib turns into ExitEvent.SIMPOINT_BEGIN.
+    cpu->scheduleInstStop(0, insts, "simpoint starting point found");
+}
+
+void
+SmartsController::startPhase()
+{
+    switch (phase) {
+      case FunctionalWarming:
+        scheduleStop(functionalCPU, functionalLength);
+        break;
+      case DetailedWarming:
+        scheduleStop(detailedCPU, detailedWarmup);
+        break;
+      case Measurement:
+        sampleStartInsts = detailedCPU->totalInsts();
+        sampleStartCycle = detailedCPU->curCycle();
+        scheduleStop(detailedCPU, unitSize);
+        break;
+      case Done:
+        break;
+    }
+}
+
+bool
+SmartsController::usesDetailedCPU() const
+{
+    return phase == DetailedWarming || phase == Measurement;
+}
+
+bool
+SmartsController::done() const
+{
+    return phase == Done;
+}
+
+} // namespace gem5
@@ -0,0 +1,81 @@
+#ifndef __BOOTCAMP_SMARTS_CONTROLLER_SMARTS_CONTROLLER_HH__
+#define __BOOTCAMP_SMARTS_CONTROLLER_SMARTS_CONTROLLER_HH__
+
+#include "base/statistics.hh"
+#include "base/stats/group.hh"
+#include "base/types.hh"
+#include "cpu/base.hh"
+#include "params/SmartsController.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+class SmartsController : public SimObject
+{
+  public:
+    enum Phase
+    {
+        FunctionalWarming,
+        DetailedWarming,
+        Measurement,
+        Done
+    };
+
+  private:
+    BaseCPU* functionalCPU;
+    BaseCPU* detailedCPU;
+
+    const uint64_t unitSize;
+    const uint64_t detailedWarmup;
+    const uint64_t functionalLength;
+
+    const double targetError;
+    const uint64_t minSamples;
+    const uint64_t maxSamples;
+    // Standard normal quantile for the two sided confidence.
+    const double z;
+
+    // The phase that is running, or about to once startPhase() is called.
+    Phase phase;
+
+    Counter sampleStartInsts;
+    Cycles sampleStartCycle;
+
+    // Running mean and sum of squared differences from it (Welford's
+    // algorithm), so the variance never needs the samples themselves.
+    uint64_t numSamples;
+    double mean;
+    double m2;
+
+    static double normalQuantile(double confidence);
+    double relativeError() const;
+    void endSample();
+    void scheduleStop(BaseCPU* cpu, uint64_t insts);
+
+    struct SmartsControllerStats : public statistics::Group
+    {
+        statistics::Scalar samples;
+        statistics::Scalar ipcMean;
+        statistics::Scalar ipcStdDev;
+        statistics::Scalar relativeError;
+        statistics::Scalar samplesNeeded;
+        SmartsControllerStats(SmartsController* controller);
+    };
+    SmartsControllerStats stats;
+
+  public:
+    SmartsController(const SmartsControllerParams& params);
+
+    // Ends the current phase and returns the next one.
+    int nextPhase();
+    // Schedules the end of the current phase on the core it runs on.
+    void startPhase();
+    bool usesDetailedCPU() const;
+    // Whether the estimate is good enough and the simulation can end.
+    bool done() const;
+};
+
+} // namespace gem5
+
+#endif // __BOOTCAMP_SMARTS_CONTROLLER_SMARTS_CONTROLLER_HH__
@@ -0,0 +1,29 @@
+from m5.objects.Probe import ProbeListenerObject
+from m5.params import *
+from m5.proxy import *
+
+class WarmupTracker(ProbeListenerObject):
+    """
+    Reports how much of a cache is warm: the blocks that are valid in its
+    tags whenever the stats are dumped, so the dump at the end of the warmup
+    gives the coverage at the switch to the detailed CPU. It also counts the
+    cache's fills through its Fill probe. Make it a child of the cache so
+    that it finds the cache's tags and size:
+    cache.warmup_tracker = WarmupTracker(manager=cache)
+
+    The tags also record, in their warmupTick stat, when warmup_percentage
+    of their blocks first became valid.
+
+    Classic caches fill and update their replacement state in atomic mode
+    too, so running the ATOMIC CPU warms them functionally at close to
+    atomic speed. KVM bypasses the caches and doesn't.
+    """
+    type = "WarmupTracker"
+    cxx_header = "bootcamp/warmup_tracker/warmup_tracker.hh"
+    cxx_class = "gem5::WarmupTracker"
+
+    tags = Param.BaseTags(Parent.tags, "Tags of the cache.")
+    size = Param.MemorySize(Parent.size, "Size of the cache.")
+    block_size = Param.Unsigned(
+        Parent.cache_line_size, "Size of the cache's blocks."
+    )
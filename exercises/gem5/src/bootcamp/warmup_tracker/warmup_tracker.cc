@@ -0,0 +1,59 @@
+#include "bootcamp/warmup_tracker/warmup_tracker.hh"
+
+#include "base/trace.hh"
+#include "debug/WarmupTracker.hh"
+#include "mem/cache/cache_blk.hh"
+
+namespace gem5
+{
+
+WarmupTracker::WarmupTracker(const WarmupTrackerParams& params):
+    ProbeListenerObject(params),
+    tags(params.tags),
+    numBlocks(params.size / params.block_size),
+    stats(this)
+{
+    fatal_if(numBlocks == 0, "%s: The cache has no blocks.", name());
+}
+
+WarmupTracker::WarmupTrackerStats::WarmupTrackerStats(WarmupTracker* tracker):
+    statistics::Group(tracker),
+    ADD_STAT(fills, statistics::units::Count::get(), "Number of blocks filled into the cache."),
+    ADD_STAT(validBlocks, statistics::units::Count::get(), "Number of valid blocks in the cache."),
+    ADD_STAT(coverage, statistics::units::Ratio::get(), "Fraction of the cache's blocks that are valid.")
+{
+    // Values aren't reset with the other stats and are read at every dump,
+    // so the dump at the end of the warmup has the blocks warm at the switch.
+    validBlocks.functor([tracker]() { return tracker->validBlocks(); });
+    coverage.functor([tracker]() {
+        return (double) tracker->validBlocks() / tracker->numBlocks;
+    });
+}
+
+void
+WarmupTracker::regProbeListeners()
+{
+    typedef ProbeListenerArg<WarmupTracker, CacheAccessProbeArg> FillListener;
+    listeners.push_back(new FillListener(this, "Fill", &WarmupTracker::fill));
+}
+
+void
+WarmupTracker::fill(const CacheAccessProbeArg& arg)
+{
+    DPRINTF(WarmupTracker, "%s: Filled for pkt: %s.\n", __func__, arg.pkt->print());
+    stats.fills++;
+}
+
+uint64_t
+WarmupTracker::validBlocks() const
+{
+    uint64_t valid = 0;
+    tags->forEachBlk([&valid](CacheBlk& blk) {
+        if (blk.isValid()) {
+            valid++;
+        }
+    });
+    return valid;
+}
+
+} // namespace gem5
@@ -0,0 +1,42 @@
+#ifndef __BOOTCAMP_WARMUP_TRACKER_WARMUP_TRACKER_HH__
+#define __BOOTCAMP_WARMUP_TRACKER_WARMUP_TRACKER_HH__
+
+#include "base/statistics.hh"
+#include "base/stats/group.hh"
+#include "base/types.hh"
+#include "mem/cache/cache_probe_arg.hh"
+#include "mem/cache/tags/base.hh"
+#include "params/WarmupTracker.hh"
+#include "sim/probe/probe.hh"
+
+namespace gem5
+{
+
+class WarmupTracker : public ProbeListenerObject
+{
+  private:
+    BaseTags* tags;
+    const uint64_t numBlocks;
+
+    void fill(const CacheAccessProbeArg& arg);
+    // Walks the tags, so only call it when the stats are read.
+    uint64_t validBlocks() const;
+
+    struct WarmupTrackerStats : public statistics::Group
+    {
+        statistics::Scalar fills;
+        statistics::Value validBlocks;
+        statistics::Value coverage;
+        WarmupTrackerStats(WarmupTracker* tracker);
+    };
+    WarmupTrackerStats stats;
+
+  public:
+    WarmupTracker(const WarmupTrackerParams& params);
+
+    void regProbeListeners() override;
+};
+
+} // namespace gem5
+
+#endif // __BOOTCAMP_WARMUP_TRACKER_WARMUP_TRACKER_HH__
@@ -1,164 +1,645 @@
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <new>
 #include <thread>
 #include <vector>
 
+#include <sys/mman.h>
+
+#ifndef GEM5
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #ifdef GEM5
 #include <gem5/m5ops.h>
 #endif
 
-void sum_1(int *array, std::atomic<int> *result, size_t length, size_t tid, size_t threads)
+#include "../include/spin_barrier.h"
+
+// Largest array we support, 8 GiB of ints. array[i] = i has to fit in an int.
+#define MAX_LENGTH (1UL << 31)
+
+// Override with -DCACHE_LINE_SIZE=128 for systems with 128 byte blocks.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+// Number of results that fit in a cache block.
+#define RESULT_STRIDE (CACHE_LINE_SIZE / sizeof(std::atomic<uint64_t>))
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+// Number of elements in one chunk of the work stealing implementation.
+#ifndef STEAL_CHUNK_SIZE
+#define STEAL_CHUNK_SIZE 256
+#endif
+
+// Backs the array with huge pages when we can so that multi-GB arrays don't
+// spend their time missing in the TLB. Falls back to transparent huge pages
+// and then to regular pages.
+int* alloc_array(size_t length, size_t &bytes)
 {
-    for (int i=tid; i < length; i += threads) {
+    bytes = (length * sizeof(int) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB) && !defined(GEM5)
+    ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (ptr == MAP_FAILED) {
+        ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            return nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+    }
+    return (int*) ptr;
+}
+
+// How the array is first written, and so which node (natively) and which
+// core's caches its pages start out in.
+enum InitPolicy
+{
+    // The main thread writes the whole array.
+    INIT_SERIAL,
+    // Each worker writes the chunk that the chunking implementations give it.
+    INIT_FIRST_TOUCH,
+    // The workers write huge page sized blocks round robin and, natively, the
+    // pages are interleaved across all NUMA nodes.
+    INIT_INTERLEAVE,
+};
+
+void init_array(int *array, size_t length, size_t tid, size_t threads, InitPolicy policy)
+{
+    if (policy == INIT_FIRST_TOUCH) {
+        size_t chunk_size = (length+threads-1)/threads;
+        for (size_t i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
+            array[i] = i;
+        }
+    } else {
+        size_t block_size = HUGE_PAGE_SIZE / sizeof(int);
+        for (size_t block=tid*block_size; block < length; block += threads*block_size) {
+            for (size_t i=block; i < block + block_size && i < length; i++) {
+                array[i] = i;
+            }
+        }
+    }
+}
+
+#ifndef GEM5
+// Interleaves the pages of the array across every node that we are allowed
+// to allocate from. This has to happen before the pages are touched.
+bool interleave_array(int *array, size_t bytes)
+{
+    unsigned long nodes = ~0UL;
+    return syscall(SYS_mbind, array, bytes, MPOL_INTERLEAVE, &nodes, sizeof(nodes) * 8, 0) == 0;
+}
+
+// Pins the calling thread to one core so that it stays next to the memory it
+// first touched.
+void pin_thread(size_t tid)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(tid % std::thread::hardware_concurrency(), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+#endif
+
+// Each thread's accumulator sits in its own cache block.
+struct alignas(CACHE_LINE_SIZE) PaddedResult
+{
+    uint64_t value;
+};
+
+// Chunks [front, back) still to be summed by a thread, packed into one word
+// as (back << 32) | front so that the owner taking from the front and
+// thieves taking from the back can't both get the same chunk.
+struct alignas(CACHE_LINE_SIZE) ChunkDeque
+{
+    std::atomic<uint64_t> range;
+    size_t chunks;
+    size_t stolen;
+};
+
+void reset_deque(ChunkDeque &deque, uint64_t front, uint64_t back)
+{
+    deque.range = (back << 32) | front;
+    deque.chunks = 0;
+    deque.stolen = 0;
+}
+
+bool take_chunk(ChunkDeque &deque, bool from_back, uint64_t &chunk)
+{
+    uint64_t range = deque.range.load();
+    while (true) {
+        uint64_t front = range & 0xffffffff;
+        uint64_t back = range >> 32;
+        if (front >= back) {
+            return false;
+        }
+        uint64_t next = from_back ? (((back - 1) << 32) | front) : ((back << 32) | (front + 1));
+        if (deque.range.compare_exchange_weak(range, next)) {
+            chunk = from_back ? back - 1 : front;
+            return true;
+        }
+    }
+}
+
+void sum_1(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
+{
+    for (size_t i=tid; i < length; i += threads) {
         *result += array[i];
     }
 }
 
-void sum_2(int *array, std::atomic<int> *result, size_t length, size_t tid, size_t threads)
+void sum_2(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
 {
     size_t chunk_size = (length+threads-1)/threads;
-    for (int i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
+    for (size_t i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
         *result += array[i];
     }
 }
 
-void sum_3(int *array, std::atomic<int> *result, size_t length, size_t tid, size_t threads)
+void sum_3(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
 {
-    for (int i=tid; i < length; i += threads) {
+    for (size_t i=tid; i < length; i += threads) {
         result[tid] += array[i];
     }
 }
 
-void sum_4(int *array, std::atomic<int> *result, size_t length, size_t tid, size_t threads)
+void sum_4(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
 {
     size_t chunk_size = (length+threads-1)/threads;
-    for (int i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
+    for (size_t i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
         result[tid] += array[i];
     }
 }
 
-void sum_5(int *array, std::atomic<int> *result, size_t length, size_t tid, size_t threads)
+void sum_5(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
+{
+    for (size_t i=tid; i < length; i += threads) {
+        result[tid*RESULT_STRIDE] += array[i];
+    }
+}
+
+void sum_6(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
+{
+    size_t chunk_size = (length+threads-1)/threads;
+    for (size_t i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
+        result[tid*RESULT_STRIDE] += array[i];
+    }
+}
+
+// Accumulates the chunk in registers and only touches the shared result once.
+// Each int is sign extended to 64 bits so that the sum can't overflow.
+void sum_7(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads)
 {
-    for (int i=tid; i < length; i += threads) {
-        result[tid*16] += array[i];
+    size_t chunk_size = (length+threads-1)/threads;
+    size_t begin = tid*chunk_size;
+    size_t end = std::min((tid+1)*chunk_size, length);
+    size_t i = begin;
+    uint64_t sum = 0;
+#if defined(__AVX2__)
+    __m256i acc_lo = _mm256_setzero_si256();
+    __m256i acc_hi = _mm256_setzero_si256();
+    for (; i + 8 <= end; i += 8) {
+        __m256i values = _mm256_loadu_si256((const __m256i*) (array + i));
+        acc_lo = _mm256_add_epi64(acc_lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+        acc_hi = _mm256_add_epi64(acc_hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, _mm256_add_epi64(acc_lo, acc_hi));
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+    __m128i acc_lo = _mm_setzero_si128();
+    __m128i acc_hi = _mm_setzero_si128();
+    for (; i + 4 <= end; i += 4) {
+        __m128i values = _mm_loadu_si128((const __m128i*) (array + i));
+        __m128i signs = _mm_srai_epi32(values, 31);
+        acc_lo = _mm_add_epi64(acc_lo, _mm_unpacklo_epi32(values, signs));
+        acc_hi = _mm_add_epi64(acc_hi, _mm_unpackhi_epi32(values, signs));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*) lanes, _mm_add_epi64(acc_lo, acc_hi));
+    sum = lanes[0] + lanes[1];
+#else
+    uint64_t partial[4] = {0, 0, 0, 0};
+    for (; i + 4 <= end; i += 4) {
+        partial[0] += array[i];
+        partial[1] += array[i + 1];
+        partial[2] += array[i + 2];
+        partial[3] += array[i + 3];
     }
+    sum = partial[0] + partial[1] + partial[2] + partial[3];
+#endif
+    for (; i < end; i++) {
+        sum += array[i];
+    }
+    *result += sum;
 }
 
-void sum_6(int *array, std::atomic<int> *result, size_t length, size_t tid, size_t threads)
+// Sums the chunk into this thread's padded accumulator and then combines the
+// accumulators pairwise in log2(threads) rounds, so that no thread has to
+// walk all of the results.
+void sum_8(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads,
+           PaddedResult *partials, SpinBarrier &barrier)
 {
     size_t chunk_size = (length+threads-1)/threads;
-    for (int i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
-        result[tid*16] += array[i];
+    partials[tid].value = 0;
+    for (size_t i=tid*chunk_size; i < (tid+1)*chunk_size && i < length; i++) {
+        partials[tid].value += array[i];
+    }
+    for (size_t stride=1; stride < threads; stride *= 2) {
+        barrier.wait();
+        if (tid % (2*stride) == 0 && tid + stride < threads) {
+            partials[tid].value += partials[tid + stride].value;
+        }
     }
+    if (tid == 0) {
+        *result += partials[0].value;
+    }
+}
+
+// Sums the chunks in this thread's deque and then steals chunks from the back
+// of the other threads' deques until every deque is empty.
+void sum_9(int *array, std::atomic<uint64_t> *result, size_t length, size_t tid, size_t threads,
+           ChunkDeque *deques)
+{
+    uint64_t chunk;
+    for (size_t victim=0; victim < threads; victim++) {
+        ChunkDeque &deque = deques[(tid + victim) % threads];
+        while (take_chunk(deque, victim != 0, chunk)) {
+            size_t begin = chunk * STEAL_CHUNK_SIZE;
+            for (size_t i=begin; i < begin + STEAL_CHUNK_SIZE && i < length; i++) {
+                result[tid*RESULT_STRIDE] += array[i];
+            }
+            deques[tid].chunks++;
+            if (victim != 0) {
+                deques[tid].stolen++;
+            }
+        }
+    }
+}
+
+// Nearest-rank percentile of the sorted samples.
+double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = (size_t) (p * sorted.size() + 0.999999);
+    return sorted[rank == 0 ? 0 : rank - 1];
 }
 
 void print_usage()
 {
     std::cout << "This program sums up an array into one number." << std::endl;
     std::cout << "Please refer to the usage below for arguments to pass." << std::endl;
-    std::cout << "{array length: int} {number of threads: int}." << std::endl;
+    std::cout << "{array length: int} {number of threads: int} [{iterations: int}] [--warmup {iterations: int}] [--json]" << std::endl;
+    std::cout << "[--init {serial|first-touch|interleave}] [--pin]." << std::endl;
+    std::cout << "Array length can be up to " << MAX_LENGTH << " (8 GiB)." << std::endl;
+    std::cout << "--warmup runs extra iterations before the measured ones (and outside the region of interest)." << std::endl;
+    std::cout << "--json prints one JSON line per measured iteration and a summary line to stdout" << std::endl;
+    std::cout << "and everything else to stderr." << std::endl;
+    std::cout << "--init picks who writes the array first: the main thread (serial, the default), each worker" << std::endl;
+    std::cout << "its own chunk (first-touch), or the workers round robin with pages interleaved across NUMA nodes" << std::endl;
+    std::cout << "(interleave). --pin pins worker i to core i. Interleaving pages and pinning only happen natively." << std::endl;
 }
 
 int main(int argc, char* argv[])
 {
-    if (argc != 3) {
+    size_t warmup = 0;
+    bool json = false;
+    InitPolicy policy = INIT_SERIAL;
+    const char* policy_name = "serial";
+    bool pin = false;
+    std::vector<char*> args;
+    for (int i=0; i<argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin = true;
+        } else if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+            policy_name = argv[++i];
+            if (strcmp(policy_name, "serial") == 0) {
+                policy = INIT_SERIAL;
+            } else if (strcmp(policy_name, "first-touch") == 0) {
+                policy = INIT_FIRST_TOUCH;
+            } else if (strcmp(policy_name, "interleave") == 0) {
+                policy = INIT_INTERLEAVE;
+            } else {
+                std::cout << "Unknown init policy " << policy_name << std::endl;
+                print_usage();
+                return 6;
+            }
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = args.size();
+    argv = args.data();
+
+    if (argc != 3 && argc != 4) {
         print_usage();
         return 1;
     }
 
-    int length = atoi(argv[1]);
+    size_t length = strtoull(argv[1], nullptr, 10);
 
-    if (length <= 0 or length > 65536) {
-        std::cout << "Array length must be above 0 and less than 65536" << std::endl;
+    if (length == 0 || length > MAX_LENGTH) {
+        std::cout << "Array length must be above 0 and at most " << MAX_LENGTH << std::endl;
         print_usage();
         return 2;
     }
 
-    int threads = atoi(argv[2]);
+    size_t threads = strtoull(argv[2], nullptr, 10);
 
-    if (threads <= 0 || threads > std::thread::hardware_concurrency()) {
-        std::cout << "Threads must be above 0 and below 8" << std::endl;
+    if (threads == 0 || threads > std::thread::hardware_concurrency()) {
+        std::cout << "Threads must be above 0 and at most " << std::thread::hardware_concurrency() << std::endl;
         print_usage();
         return 3;
     }
 
-    std::cout << "Initializing array and reseting result." << std::endl;
-    int* array = new int[length];
-    std::atomic<int>* result = new std::atomic<int> [threads * 16]; // Enough room for 64 bytes for each int
-    for (int i=0; i<threads*16; i++) {
-        result[i] = 0;
+    size_t iterations = 1;
+    if (argc == 4) {
+        iterations = strtoull(argv[3], nullptr, 10);
+        if (iterations == 0) {
+            std::cout << "Iterations must be above 0" << std::endl;
+            print_usage();
+            return 5;
+        }
+    }
+
+    // Keep stdout to the JSON lines in harness mode.
+    std::ostream &out = json ? std::cerr : std::cout;
+
+    out << "Initializing array and reseting result." << std::endl;
+    size_t array_bytes;
+    int* array = alloc_array(length, array_bytes);
+    if (array == nullptr) {
+        std::cout << "Could not allocate " << length << " ints." << std::endl;
+        return 4;
     }
-    for (int i=0; i<length; i++) {
-        array[i] = i;
+    // Enough room for a cache block for each result, starting on a block boundary.
+    std::atomic<uint64_t>* result = (std::atomic<uint64_t>*) std::aligned_alloc(
+        CACHE_LINE_SIZE, threads * RESULT_STRIDE * sizeof(std::atomic<uint64_t>));
+    for (size_t i=0; i<threads*RESULT_STRIDE; i++) {
+        new (&result[i]) std::atomic<uint64_t>(0);
+    }
+#ifndef GEM5
+    if (policy == INIT_INTERLEAVE && !interleave_array(array, array_bytes)) {
+        out << "Could not interleave the array across NUMA nodes." << std::endl;
+    }
+#endif
+    if (policy == INIT_SERIAL) {
+        for (size_t i=0; i<length; i++) {
+            array[i] = i;
+        }
     }
     std::vector<std::thread> thread_pool;
-    std::cout << "Done initializing." << std::endl;
 
 #ifdef NAIVE
     auto func = sum_1;
-    std::cout << "Using a naive approach to sum up the array." << std::endl;
+    const char* variant = "naive";
+    out << "Using a naive approach to sum up the array." << std::endl;
 #endif
 
 #ifdef CHUNKING
     auto func = sum_2;
-    std::cout << "Chunking the array for summation." << std::endl;
+    const char* variant = "chunking";
+    out << "Chunking the array for summation." << std::endl;
 #endif
 
 #ifdef RES_RACE_OPT
     auto func = sum_3;
-    std::cout << "Removing race condition on result." << std::endl;
+    const char* variant = "res-race-opt";
+    out << "Removing race condition on result." << std::endl;
 #endif
 
 #ifdef CHUNKING_RES_RACE_OPT
     auto func = sum_4;
-    std::cout << "Removing race condition on result and using chunking." << std::endl;
+    const char* variant = "chunking-res-race-opt";
+    out << "Removing race condition on result and using chunking." << std::endl;
 #endif
 
 #ifdef BLOCK_RACE_OPT
     auto func = sum_5;
-    std::cout << "Removing race condition on cache blocks holding result array." << std::endl;
+    const char* variant = "block-race-opt";
+    out << "Removing race condition on cache blocks holding result array." << std::endl;
 #endif
 
 #ifdef ALL_OPT
     auto func = sum_6;
-    std::cout << "Removing race condition on cache blocks and using chunking to sum up the array." << std::endl;
+    const char* variant = "all-opt";
+    out << "Removing race condition on cache blocks and using chunking to sum up the array." << std::endl;
 #endif
 
-    std::cout << "Beginning summation ..." << std::endl;
-    auto start = std::chrono::high_resolution_clock::now();
+#ifdef SIMD_OPT
+    auto func = sum_7;
+    const char* variant = "simd-opt";
+    out << "Accumulating chunks in vector registers with one atomic add per thread." << std::endl;
+#endif
 
-#ifdef GEM5
-    m5_work_begin(0, 0);
+#ifdef TREE_OPT
+    auto func = sum_8;
+    const char* variant = "tree-opt";
+    PaddedResult* partials = new PaddedResult[threads];
+    SpinBarrier tree_barrier(threads);
+    out << "Using padded per-thread results and a tree reduction." << std::endl;
 #endif
 
-#if defined(NAIVE) || defined(CHUNKING) || defined(RES_RACE_OPT) || defined(CHUNKING_RES_RACE_OPT) || defined(BLOCK_RACE_OPT) || defined(ALL_OPT)
-    for (int i=0; i<threads; i++) {
-        thread_pool.emplace_back(func, array, result, length, i, threads);
-    }
+#ifdef WORK_STEALING
+    auto func = sum_9;
+    const char* variant = "work-stealing";
+    ChunkDeque* deques = new ChunkDeque[threads];
+    uint64_t num_chunks = (length + STEAL_CHUNK_SIZE - 1) / STEAL_CHUNK_SIZE;
+    uint64_t chunks_per_thread = (num_chunks + threads - 1) / threads;
+    out << "Stealing chunks of " << STEAL_CHUNK_SIZE << " elements between threads." << std::endl;
+#endif
 
-    for (auto &thread: thread_pool) {
-        thread.join();
+    // Spawn the workers before the region of interest and only release them
+    // through the barrier so that thread creation isn't measured.
+    SpinBarrier barrier(threads + 1);
+    PaddedResult* thread_times = new PaddedResult[threads];
+#if defined(NAIVE) || defined(CHUNKING) || defined(RES_RACE_OPT) || defined(CHUNKING_RES_RACE_OPT) || defined(BLOCK_RACE_OPT) || defined(ALL_OPT) || defined(SIMD_OPT) || defined(TREE_OPT) || defined(WORK_STEALING)
+    for (size_t i=0; i<threads; i++) {
+        thread_pool.emplace_back([&, i]() {
+#ifndef GEM5
+            if (pin) {
+                pin_thread(i);
+            }
+#endif
+            if (policy != INIT_SERIAL) {
+                init_array(array, length, i, threads, policy);
+            }
+            barrier.wait();
+            for (size_t it=0; it<warmup+iterations; it++) {
+                barrier.wait();
+                auto thread_start = std::chrono::steady_clock::now();
+#if defined(TREE_OPT)
+                func(array, result, length, i, threads, partials, tree_barrier);
+#elif defined(WORK_STEALING)
+                func(array, result, length, i, threads, deques);
+#else
+                func(array, result, length, i, threads);
+#endif
+                thread_times[i].value = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - thread_start).count();
+                barrier.wait();
+            }
+        });
     }
+#endif
+    // Wait for the workers to initialize their part of the array.
+    barrier.wait();
+    out << "Done initializing " << policy_name << "." << std::endl;
 
-    for (int i=1; i<threads*16; i++) {
-        result[0] += result[i];
-    }
+    uint64_t expected = ((uint64_t) length) * (length - 1) / 2;
+    std::vector<double> times;
+    std::vector<double> total_thread_times(threads, 0);
+    for (size_t it=0; it<warmup+iterations; it++) {
+        // Warm-up iterations run outside of the region of interest.
+        bool measured = it >= warmup;
+        size_t work_id = it - warmup;
+        for (size_t i=0; i<threads*RESULT_STRIDE; i++) {
+            result[i] = 0;
+        }
+#ifdef WORK_STEALING
+        for (size_t i=0; i<threads; i++) {
+            reset_deque(deques[i], std::min(i * chunks_per_thread, num_chunks),
+                        std::min((i + 1) * chunks_per_thread, num_chunks));
+        }
 #endif
 
+        out << "Beginning summation ..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+
 #ifdef GEM5
-    m5_work_end(0, 0);
+        if (measured) {
+            m5_work_begin(work_id, 0);
+        }
+#endif
+
+        barrier.wait();
+        barrier.wait();
+
+#ifndef TREE_OPT
+        for (size_t i=1; i<threads*RESULT_STRIDE; i++) {
+            result[0] += result[i];
+        }
 #endif
 
-    auto end = std::chrono::high_resolution_clock::now();
+#ifdef GEM5
+        if (measured) {
+            m5_work_end(work_id, 0);
+        }
+#endif
 
-    std::cout << "Done." << std::endl;
-    std::cout << "Time " << (double) (end - start).count() / 1e6 << " ms" << std::endl;
-    if (result[0] != ((uint) length) * ((uint)(length - 1)) / 2) {
-        std::cout << "ERROR: RESULT WRONG!" << std::endl;
-        std::cout << "Expected " << ((uint)length)*((uint)(length-1))/2 << " got " << result[0] << std::endl;
+        auto end = std::chrono::steady_clock::now();
+
+        out << "Done." << std::endl;
+        double time = std::chrono::duration<double, std::milli>(end - start).count();
+        bool correct = result[0] == expected;
+        if (!correct) {
+            out << "ERROR: RESULT WRONG!" << std::endl;
+            out << "Expected " << expected << " got " << result[0] << std::endl;
+        }
+        if (!measured) {
+            out << "Warm-up time " << time << " ms" << std::endl;
+            continue;
+        }
+        times.push_back(time);
+        out << "Time " << time << " ms" << std::endl;
+#ifdef WORK_STEALING
+        for (size_t i=0; i<threads; i++) {
+            out << "Thread " << i << " summed " << deques[i].chunks << " chunks ("
+                << deques[i].stolen << " stolen)" << std::endl;
+        }
+#endif
+        if (json) {
+            std::cout << "{\"type\": \"sample\", \"variant\": \"" << variant << "\", \"length\": " << length
+                      << ", \"threads\": " << threads << ", \"iteration\": " << work_id
+                      << ", \"time_ms\": " << time << ", \"correct\": " << (correct ? "true" : "false")
+                      << ", \"thread_time_ms\": [";
+            for (size_t i=0; i<threads; i++) {
+                std::cout << (i ? ", " : "") << thread_times[i].value / 1e6;
+            }
+            std::cout << "]";
+#ifdef WORK_STEALING
+            std::cout << ", \"thread_chunks\": [";
+            for (size_t i=0; i<threads; i++) {
+                std::cout << (i ? ", " : "") << deques[i].chunks;
+            }
+            std::cout << "], \"thread_stolen\": [";
+            for (size_t i=0; i<threads; i++) {
+                std::cout << (i ? ", " : "") << deques[i].stolen;
+            }
+            std::cout << "]";
+#endif
+            std::cout << "}" << std::endl;
+        }
+        for (size_t i=0; i<threads; i++) {
+            total_thread_times[i] += thread_times[i].value / 1e6;
+        }
+    }
+
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    double median = sorted.size() % 2 ? sorted[sorted.size() / 2]
+        : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+    if (iterations > 1) {
+        double total_time = 0;
+        for (double time: times) {
+            total_time += time;
+        }
+        out << "Average time " << total_time / iterations << " ms over " << iterations << " iterations" << std::endl;
+        out << "Min " << sorted.front() << " ms, median " << median << " ms, p95 "
+            << percentile(sorted, 0.95) << " ms" << std::endl;
+    }
+    if (json) {
+        // Throughput is based on the median time.
+        std::cout << "{\"type\": \"summary\", \"variant\": \"" << variant << "\", \"length\": " << length
+                  << ", \"threads\": " << threads << ", \"init\": \"" << policy_name
+                  << "\", \"pin\": " << (pin ? "true" : "false") << ", \"warmup\": " << warmup
+                  << ", \"iterations\": " << iterations << ", \"cache_line_size\": " << CACHE_LINE_SIZE
+                  << ", \"min_ms\": " << sorted.front() << ", \"median_ms\": " << median
+                  << ", \"p95_ms\": " << percentile(sorted, 0.95) << ", \"max_ms\": " << sorted.back()
+                  << ", \"gb_per_s\": " << length * sizeof(int) / (median * 1e6)
+                  << ", \"elements_per_s\": " << length / (median / 1e3)
+                  << ", \"thread_mean_ms\": [";
+        for (size_t i=0; i<threads; i++) {
+            std::cout << (i ? ", " : "") << total_thread_times[i] / iterations;
+        }
+        std::cout << "]}" << std::endl;
     }
 
-    delete[] array;
-    delete[] result;
+    for (auto &thread: thread_pool) {
+        thread.join();
+    }
+
+    munmap(array, array_bytes);
+    std::free(result);
+    delete[] thread_times;
+#ifdef TREE_OPT
+    delete[] partials;
+#endif
+#ifdef WORK_STEALING
+    delete[] deques;
+#endif
     return 0;
 }
@@ -32,79 +32,145 @@ from .custom_se_workload import CustomSEWorkload
 this_dir = pathlib.Path(__file__).parent.absolute()
 
 
+def _arguments(array_size: int, num_threads: int, iterations: int):
+    # Only pass iterations when it isn't the default, so that binaries built
+    # before it was added (which take exactly two arguments) still run.
+    arguments = [array_size, num_threads]
+    if iterations != 1:
+        arguments.append(iterations)
+    return arguments
+
+
 class NaiveArraySumWorkload(CustomSEWorkload):
-    def __init__(self, array_size: int, num_threads: int):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
         array_sum_bin = BinaryResource(
             local_path=str(this_dir / "array_sum/naive-gem5")
         )
         super().__init__(
             parameters={
                 "binary": array_sum_bin,
-                "arguments": [array_size, num_threads],
+                "arguments": _arguments(array_size, num_threads, iterations),
             }
         )
 
 
 class ChunkingArraySumWorkload(CustomSEWorkload):
-    def __init__(self, array_size: int, num_threads: int):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
         array_sum_bin = BinaryResource(
             local_path=str(this_dir / "array_sum/chunking-gem5")
         )
         super().__init__(
             parameters={
                 "binary": array_sum_bin,
-                "arguments": [array_size, num_threads],
+                "arguments": _arguments(array_size, num_threads, iterations),
             }
         )
 
 
 class NoResultRaceArraySumWorkload(CustomSEWorkload):
-    def __init__(self, array_size: int, num_threads: int):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
         array_sum_bin = BinaryResource(
             local_path=str(this_dir / "array_sum/res-race-opt-gem5")
         )
         super().__init__(
             parameters={
                 "binary": array_sum_bin,
-                "arguments": [array_size, num_threads],
+                "arguments": _arguments(array_size, num_threads, iterations),
             }
         )
 
 
 class ChunkingNoResultRaceArraySumWorkload(CustomSEWorkload):
-    def __init__(self, array_size: int, num_threads: int):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
         array_sum_bin = BinaryResource(
             local_path=str(this_dir / "array_sum/chunking-res-race-opt-gem5")
         )
         super().__init__(
             parameters={
                 "binary": array_sum_bin,
-                "arguments": [array_size, num_threads],
+                "arguments": _arguments(array_size, num_threads, iterations),
             }
         )
 
 
 class NoCacheBlockRaceArraySumWorkload(CustomSEWorkload):
-    def __init__(self, array_size: int, num_threads: int):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
         array_sum_bin = BinaryResource(
             local_path=str(this_dir / "array_sum/block-race-opt-gem5")
         )
         super().__init__(
             parameters={
                 "binary": array_sum_bin,
-                "arguments": [array_size, num_threads],
+                "arguments": _arguments(array_size, num_threads, iterations),
             }
         )
 
 
 class ChunkingNoBlockRaceArraySumWorkload(CustomSEWorkload):
-    def __init__(self, array_size: int, num_threads: int):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
         array_sum_bin = BinaryResource(
             local_path=str(this_dir / "array_sum/all-opt-gem5")
         )
         super().__init__(
             parameters={
                 "binary": array_sum_bin,
-                "arguments": [array_size, num_threads],
+                "arguments": _arguments(array_size, num_threads, iterations),
+            }
+        )
+
+
+class VectorizedArraySumWorkload(CustomSEWorkload):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
+        array_sum_bin = BinaryResource(
+            local_path=str(this_dir / "array_sum/simd-opt-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": array_sum_bin,
+                "arguments": _arguments(array_size, num_threads, iterations),
+            }
+        )
+
+
+class TreeReductionArraySumWorkload(CustomSEWorkload):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
+        array_sum_bin = BinaryResource(
+            local_path=str(this_dir / "array_sum/tree-opt-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": array_sum_bin,
+                "arguments": _arguments(array_size, num_threads, iterations),
+            }
+        )
+
+
+class WorkStealingArraySumWorkload(CustomSEWorkload):
+    def __init__(
+        self, array_size: int, num_threads: int, iterations: int = 1
+    ):
+        array_sum_bin = BinaryResource(
+            local_path=str(this_dir / "array_sum/work-stealing-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": array_sum_bin,
+                "arguments": _arguments(array_size, num_threads, iterations),
             }
         )
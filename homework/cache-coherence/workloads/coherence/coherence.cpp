@@ -0,0 +1,446 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef GEM5
+#include <gem5/m5ops.h>
+#endif
+
+#include "../include/spin_barrier.h"
+
+// Override with -DCACHE_LINE_SIZE=128 for systems with 128 byte blocks.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+// Slots in each SPSC ring.
+#ifndef RING_SIZE
+#define RING_SIZE 64
+#endif
+
+// Entries in the reader heavy table, and one in WRITE_RATIO operations on it
+// is a write.
+#ifndef TABLE_SIZE
+#define TABLE_SIZE 1024
+#endif
+#ifndef WRITE_RATIO
+#define WRITE_RATIO 16
+#endif
+
+// Bins in each thread's histogram. With 4 bins two threads share a block.
+#ifndef HISTOGRAM_BINS
+#define HISTOGRAM_BINS 4
+#endif
+
+struct alignas(CACHE_LINE_SIZE) PaddedCounter
+{
+    std::atomic<uint64_t> value;
+};
+
+// Cheap per-thread pseudo random numbers so that the kernels don't share
+// (or make system calls for) a random number generator.
+uint64_t next_random(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Every kernel below has the same interface. The constructor sets up the
+// shared data, reset() runs before each iteration, run(tid) is what each
+// thread does in the region of interest, and check() verifies the result.
+
+// The threads take turns incrementing one counter, so the block holding it
+// moves from cache to cache on every operation.
+class PingPong
+{
+  private:
+    const size_t threads;
+    const size_t ops;
+    PaddedCounter counter;
+
+  public:
+    static constexpr const char* description = "Passing one counter between the threads in turn.";
+
+    PingPong(size_t threads, size_t ops): threads(threads), ops(ops) {}
+
+    static bool validThreads(size_t) { return true; }
+
+    void reset() { counter.value = 0; }
+
+    void run(size_t tid)
+    {
+        for (size_t i=0; i<ops; i++) {
+            uint64_t turn = i * threads + tid;
+            while (counter.value.load(std::memory_order_acquire) != turn) {
+            }
+            counter.value.store(turn + 1, std::memory_order_release);
+        }
+    }
+
+    bool check() { return counter.value == threads * ops; }
+};
+
+// Pairs of threads (2k, 2k+1) pass values through a bounded ring. The head
+// and the tail are each in their own block so the only sharing is the
+// producer and consumer handing off slots and indices.
+class SPSCRing
+{
+  private:
+    struct alignas(CACHE_LINE_SIZE) Ring
+    {
+        uint64_t slots[RING_SIZE];
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+        alignas(CACHE_LINE_SIZE) uint64_t sum;
+    };
+
+    const size_t threads;
+    const size_t ops;
+    std::vector<Ring> rings;
+
+  public:
+    static constexpr const char* description = "Passing values from producers to consumers through SPSC rings.";
+
+    SPSCRing(size_t threads, size_t ops): threads(threads), ops(ops), rings(threads / 2) {}
+
+    static bool validThreads(size_t threads) { return threads % 2 == 0; }
+
+    void reset()
+    {
+        for (auto &ring: rings) {
+            ring.head = 0;
+            ring.tail = 0;
+            ring.sum = 0;
+        }
+    }
+
+    void run(size_t tid)
+    {
+        Ring &ring = rings[tid / 2];
+        if (tid % 2 == 0) {
+            for (uint64_t i=0; i<ops; i++) {
+                uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+                while (tail - ring.head.load(std::memory_order_acquire) == RING_SIZE) {
+                }
+                ring.slots[tail % RING_SIZE] = i;
+                ring.tail.store(tail + 1, std::memory_order_release);
+            }
+        } else {
+            for (uint64_t i=0; i<ops; i++) {
+                uint64_t head = ring.head.load(std::memory_order_relaxed);
+                while (ring.tail.load(std::memory_order_acquire) == head) {
+                }
+                ring.sum += ring.slots[head % RING_SIZE];
+                ring.head.store(head + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    bool check()
+    {
+        for (auto &ring: rings) {
+            if (ring.sum != ((uint64_t) ops) * (ops - 1) / 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Every thread reads random entries of a shared table and increments one in
+// WRITE_RATIO of them, so most blocks are shared and a few get invalidated.
+class ReaderHeavyTable
+{
+  private:
+    const size_t threads;
+    const size_t ops;
+    std::vector<std::atomic<uint64_t>> table;
+    std::vector<PaddedCounter> reads;
+
+  public:
+    static constexpr const char* description = "Reading a shared table with occasional writes.";
+
+    ReaderHeavyTable(size_t threads, size_t ops): threads(threads), ops(ops), table(TABLE_SIZE), reads(threads) {}
+
+    static bool validThreads(size_t) { return true; }
+
+    void reset()
+    {
+        for (auto &entry: table) {
+            entry = 0;
+        }
+    }
+
+    void run(size_t tid)
+    {
+        uint64_t state = tid + 1;
+        uint64_t sum = 0;
+        for (size_t i=0; i<ops; i++) {
+            size_t entry = next_random(state) % TABLE_SIZE;
+            if (i % WRITE_RATIO == 0) {
+                table[entry].fetch_add(1, std::memory_order_relaxed);
+            } else {
+                sum += table[entry].load(std::memory_order_relaxed);
+            }
+        }
+        // Keep the reads from being optimized away.
+        reads[tid].value = sum;
+    }
+
+    bool check()
+    {
+        uint64_t writes = 0;
+        for (auto &entry: table) {
+            writes += entry;
+        }
+        return writes == threads * ((ops + WRITE_RATIO - 1) / WRITE_RATIO);
+    }
+};
+
+// The threads take a test and test and set lock and update the data it
+// protects, so the lock and the data migrate together from core to core.
+class MigratoryLock
+{
+  private:
+    struct alignas(CACHE_LINE_SIZE) Protected
+    {
+        std::atomic<bool> locked;
+        uint64_t counter;
+        uint64_t owner;
+        uint64_t data[4];
+    };
+
+    const size_t threads;
+    const size_t ops;
+    Protected shared;
+
+  public:
+    static constexpr const char* description = "Migrating a lock and the data it protects between threads.";
+
+    MigratoryLock(size_t threads, size_t ops): threads(threads), ops(ops) {}
+
+    static bool validThreads(size_t) { return true; }
+
+    void reset()
+    {
+        shared.locked = false;
+        shared.counter = 0;
+        shared.owner = 0;
+        for (auto &value: shared.data) {
+            value = 0;
+        }
+    }
+
+    void run(size_t tid)
+    {
+        for (size_t i=0; i<ops; i++) {
+            while (true) {
+                while (shared.locked.load(std::memory_order_relaxed)) {
+                }
+                if (!shared.locked.exchange(true, std::memory_order_acquire)) {
+                    break;
+                }
+            }
+            shared.counter++;
+            shared.owner = tid;
+            shared.data[shared.counter % 4] += tid;
+            shared.locked.store(false, std::memory_order_release);
+        }
+    }
+
+    bool check() { return shared.counter == threads * ops; }
+};
+
+// Each thread updates only its own histogram, but the histograms are packed
+// next to each other (unless PADDED_HISTOGRAM) so neighbouring threads
+// falsely share blocks.
+class Histogram
+{
+  private:
+#ifdef PADDED_HISTOGRAM
+    struct alignas(CACHE_LINE_SIZE) Bins
+#else
+    struct Bins
+#endif
+    {
+        std::atomic<uint64_t> counts[HISTOGRAM_BINS];
+    };
+
+    const size_t threads;
+    const size_t ops;
+    Bins* bins;
+
+  public:
+#ifdef PADDED_HISTOGRAM
+    static constexpr const char* description = "Updating per-thread histograms padded to a cache block.";
+#else
+    static constexpr const char* description = "Updating per-thread histograms that share cache blocks.";
+#endif
+
+    Histogram(size_t threads, size_t ops): threads(threads), ops(ops)
+    {
+        bins = (Bins*) std::aligned_alloc(CACHE_LINE_SIZE,
+            (threads * sizeof(Bins) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+    }
+
+    ~Histogram() { std::free(bins); }
+
+    static bool validThreads(size_t) { return true; }
+
+    void reset()
+    {
+        for (size_t t=0; t<threads; t++) {
+            for (auto &count: bins[t].counts) {
+                count = 0;
+            }
+        }
+    }
+
+    void run(size_t tid)
+    {
+        uint64_t state = tid + 1;
+        for (size_t i=0; i<ops; i++) {
+            // Only this thread writes these bins, so it doesn't need an
+            // atomic add, but every update has to reach the cache.
+            std::atomic<uint64_t> &count = bins[tid].counts[next_random(state) % HISTOGRAM_BINS];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    bool check()
+    {
+        for (size_t t=0; t<threads; t++) {
+            uint64_t total = 0;
+            for (auto &count: bins[t].counts) {
+                total += count;
+            }
+            if (total != ops) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#ifdef PING_PONG
+using Kernel = PingPong;
+#endif
+
+#ifdef SPSC_RING
+using Kernel = SPSCRing;
+#endif
+
+#ifdef READER_TABLE
+using Kernel = ReaderHeavyTable;
+#endif
+
+#ifdef MIGRATORY_LOCK
+using Kernel = MigratoryLock;
+#endif
+
+#if defined(HISTOGRAM) || defined(PADDED_HISTOGRAM)
+using Kernel = Histogram;
+#endif
+
+void print_usage()
+{
+    std::cout << "This program runs one kernel that stresses the cache coherence protocol." << std::endl;
+    std::cout << "Please refer to the usage below for arguments to pass." << std::endl;
+    std::cout << "{number of threads: int} {operations per thread: int} [{iterations: int}]." << std::endl;
+    std::cout << "The SPSC ring needs an even number of threads." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3 && argc != 4) {
+        print_usage();
+        return 1;
+    }
+
+    size_t threads = strtoull(argv[1], nullptr, 10);
+
+    if (threads == 0 || threads > std::thread::hardware_concurrency() || !Kernel::validThreads(threads)) {
+        std::cout << "Threads must be above 0 and at most " << std::thread::hardware_concurrency() << std::endl;
+        print_usage();
+        return 2;
+    }
+
+    size_t ops = strtoull(argv[2], nullptr, 10);
+
+    if (ops == 0) {
+        std::cout << "Operations must be above 0" << std::endl;
+        print_usage();
+        return 3;
+    }
+
+    size_t iterations = 1;
+    if (argc == 4) {
+        iterations = strtoull(argv[3], nullptr, 10);
+        if (iterations == 0) {
+            std::cout << "Iterations must be above 0" << std::endl;
+            print_usage();
+            return 4;
+        }
+    }
+
+    Kernel kernel(threads, ops);
+    std::cout << Kernel::description << std::endl;
+
+    // The kernel's threads all exist before the first iteration starts, so
+    // each region of interest holds only the kernel's own traffic.
+    SpinBarrier barrier(threads + 1);
+    std::vector<std::thread> thread_pool;
+    for (size_t i=0; i<threads; i++) {
+        thread_pool.emplace_back([&, i]() {
+            for (size_t it=0; it<iterations; it++) {
+                barrier.wait();
+                kernel.run(i);
+                barrier.wait();
+            }
+        });
+    }
+
+    double total_time = 0;
+    for (size_t it=0; it<iterations; it++) {
+        kernel.reset();
+
+        std::cout << "Beginning kernel ..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+
+#ifdef GEM5
+        m5_work_begin(it, 0);
+#endif
+
+        barrier.wait();
+        barrier.wait();
+
+#ifdef GEM5
+        m5_work_end(it, 0);
+#endif
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Done." << std::endl;
+        double time = std::chrono::duration<double, std::milli>(end - start).count();
+        total_time += time;
+        std::cout << "Time " << time << " ms" << std::endl;
+        if (!kernel.check()) {
+            std::cout << "ERROR: RESULT WRONG!" << std::endl;
+        }
+    }
+    if (iterations > 1) {
+        std::cout << "Average time " << total_time / iterations << " ms over " << iterations << " iterations" << std::endl;
+    }
+
+    for (auto &thread: thread_pool) {
+        thread.join();
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+# Copyright (c) 2022 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import pathlib
+
+from gem5.resources.resource import BinaryResource
+from .custom_se_workload import CustomSEWorkload
+
+this_dir = pathlib.Path(__file__).parent.absolute()
+
+
+class PingPongWorkload(CustomSEWorkload):
+    def __init__(
+        self, num_threads: int, num_operations: int, iterations: int = 1
+    ):
+        coherence_bin = BinaryResource(
+            local_path=str(this_dir / "coherence/ping-pong-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": coherence_bin,
+                "arguments": [num_threads, num_operations, iterations],
+            }
+        )
+
+
+class SPSCRingWorkload(CustomSEWorkload):
+    def __init__(
+        self, num_threads: int, num_operations: int, iterations: int = 1
+    ):
+        coherence_bin = BinaryResource(
+            local_path=str(this_dir / "coherence/spsc-ring-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": coherence_bin,
+                "arguments": [num_threads, num_operations, iterations],
+            }
+        )
+
+
+class ReaderHeavyTableWorkload(CustomSEWorkload):
+    def __init__(
+        self, num_threads: int, num_operations: int, iterations: int = 1
+    ):
+        coherence_bin = BinaryResource(
+            local_path=str(this_dir / "coherence/reader-table-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": coherence_bin,
+                "arguments": [num_threads, num_operations, iterations],
+            }
+        )
+
+
+class MigratoryLockWorkload(CustomSEWorkload):
+    def __init__(
+        self, num_threads: int, num_operations: int, iterations: int = 1
+    ):
+        coherence_bin = BinaryResource(
+            local_path=str(this_dir / "coherence/migratory-lock-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": coherence_bin,
+                "arguments": [num_threads, num_operations, iterations],
+            }
+        )
+
+
+class FalseSharingHistogramWorkload(CustomSEWorkload):
+    def __init__(
+        self, num_threads: int, num_operations: int, iterations: int = 1
+    ):
+        coherence_bin = BinaryResource(
+            local_path=str(this_dir / "coherence/histogram-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": coherence_bin,
+                "arguments": [num_threads, num_operations, iterations],
+            }
+        )
+
+
+class PaddedHistogramWorkload(CustomSEWorkload):
+    def __init__(
+        self, num_threads: int, num_operations: int, iterations: int = 1
+    ):
+        coherence_bin = BinaryResource(
+            local_path=str(this_dir / "coherence/padded-histogram-gem5")
+        )
+        super().__init__(
+            parameters={
+                "binary": coherence_bin,
+                "arguments": [num_threads, num_operations, iterations],
+            }
+        )
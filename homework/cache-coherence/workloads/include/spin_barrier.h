@@ -0,0 +1,38 @@
+#ifndef __SPIN_BARRIER_H__
+#define __SPIN_BARRIER_H__
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+// Barrier for the worker pools of the homework workloads. The last thread to
+// arrive resets the count and bumps a generation counter. The others spin
+// (yielding) until the generation changes instead of sleeping, so releasing
+// them doesn't depend on the OS scheduler or on gem5's syscall emulation of
+// futexes. Reading the generation before arriving lets the same barrier be
+// reused right away for the next phase.
+class SpinBarrier
+{
+  private:
+    const size_t threads;
+    std::atomic<size_t> count;
+    std::atomic<size_t> generation;
+
+  public:
+    SpinBarrier(size_t threads): threads(threads), count(0), generation(0) {}
+
+    void wait()
+    {
+        size_t gen = generation.load();
+        if (count.fetch_add(1) + 1 == threads) {
+            count = 0;
+            generation.fetch_add(1);
+        } else {
+            while (generation.load() == gen) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+#endif // __SPIN_BARRIER_H__
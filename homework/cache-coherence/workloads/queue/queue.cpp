@@ -0,0 +1,354 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef GEM5
+#include <gem5/m5ops.h>
+#endif
+
+#include "../include/spin_barrier.h"
+
+// Override with -DCACHE_LINE_SIZE=128 for systems with 128 byte blocks.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+// Slots in each queue. Has to be a power of two.
+#ifndef QUEUE_SIZE
+#define QUEUE_SIZE 256
+#endif
+
+static_assert((QUEUE_SIZE & (QUEUE_SIZE - 1)) == 0, "QUEUE_SIZE has to be a power of two");
+
+// Bounded single producer, single consumer ring. Only the producer writes
+// tail and only the consumer writes head, so neither needs an atomic
+// read-modify-write. Each keeps a cached copy of the other's index so it
+// only reads the shared one when the ring looks full (or empty).
+class SPSCQueue
+{
+  private:
+    const size_t payload;
+    uint8_t* slots;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+    size_t cachedTail;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+    size_t cachedHead;
+
+  public:
+    SPSCQueue(size_t payload): payload(payload), head(0), cachedTail(0), tail(0), cachedHead(0)
+    {
+        slots = new uint8_t[QUEUE_SIZE * payload];
+    }
+
+    ~SPSCQueue() { delete[] slots; }
+
+    void reset()
+    {
+        head = 0;
+        tail = 0;
+        cachedHead = 0;
+        cachedTail = 0;
+    }
+
+    bool push(const uint8_t* data)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        if (pos - cachedHead == QUEUE_SIZE) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (pos - cachedHead == QUEUE_SIZE) {
+                return false;
+            }
+        }
+        std::memcpy(slots + (pos & (QUEUE_SIZE - 1)) * payload, data, payload);
+        tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(uint8_t* data)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        if (pos == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (pos == cachedTail) {
+                return false;
+            }
+        }
+        std::memcpy(data, slots + (pos & (QUEUE_SIZE - 1)) * payload, payload);
+        head.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Bounded multi producer, multi consumer queue after Dmitry Vyukov's. Each
+// cell has a sequence number that says whether it is ready to be written
+// (sequence == position) or read (sequence == position + 1), so producers
+// and consumers only contend on their own position counter.
+class MPMCQueue
+{
+  private:
+    const size_t payload;
+    // Size of a cell, its sequence number followed by the payload, rounded
+    // up to keep the sequence numbers aligned.
+    const size_t cellSize;
+    uint8_t* cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+
+    std::atomic<size_t>& sequence(size_t pos)
+    {
+        return *(std::atomic<size_t>*) (cells + (pos & (QUEUE_SIZE - 1)) * cellSize);
+    }
+
+    uint8_t* data(size_t pos)
+    {
+        return cells + (pos & (QUEUE_SIZE - 1)) * cellSize + sizeof(std::atomic<size_t>);
+    }
+
+  public:
+    MPMCQueue(size_t payload):
+        payload(payload),
+        cellSize((sizeof(std::atomic<size_t>) + payload + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t)),
+        enqueuePos(0), dequeuePos(0)
+    {
+        cells = (uint8_t*) std::aligned_alloc(CACHE_LINE_SIZE,
+            (QUEUE_SIZE * cellSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+        reset();
+    }
+
+    ~MPMCQueue() { std::free(cells); }
+
+    void reset()
+    {
+        for (size_t i=0; i<QUEUE_SIZE; i++) {
+            new (&sequence(i)) std::atomic<size_t>(i);
+        }
+        enqueuePos = 0;
+        dequeuePos = 0;
+    }
+
+    bool push(const uint8_t* value)
+    {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            size_t seq = sequence(pos).load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        std::memcpy(data(pos), value, payload);
+        sequence(pos).store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(uint8_t* value)
+    {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            size_t seq = sequence(pos).load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        std::memcpy(value, data(pos), payload);
+        sequence(pos).store(pos + QUEUE_SIZE, std::memory_order_release);
+        return true;
+    }
+};
+
+struct alignas(CACHE_LINE_SIZE) PaddedSum
+{
+    uint64_t value;
+};
+
+void print_usage()
+{
+    std::cout << "This program passes messages from producer threads to consumer threads through lock-free queues." << std::endl;
+    std::cout << "Please refer to the usage below for arguments to pass." << std::endl;
+    std::cout << "{producers: int} {consumers: int} {messages per producer: int} [{payload bytes: int}] [{iterations: int}]." << std::endl;
+    std::cout << "The payload is at least 8 bytes (the default)." << std::endl;
+    std::cout << "The SPSC queue needs as many consumers as producers, producer i sends to consumer i." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4 || argc > 6) {
+        print_usage();
+        return 1;
+    }
+
+    size_t producers = strtoull(argv[1], nullptr, 10);
+    size_t consumers = strtoull(argv[2], nullptr, 10);
+    size_t threads = producers + consumers;
+
+    if (producers == 0 || consumers == 0 || threads > std::thread::hardware_concurrency()) {
+        std::cout << "Producers and consumers must be above 0 and add up to at most "
+                  << std::thread::hardware_concurrency() << std::endl;
+        print_usage();
+        return 2;
+    }
+
+#ifdef SPSC
+    if (producers != consumers) {
+        std::cout << "The SPSC queue needs as many consumers as producers" << std::endl;
+        print_usage();
+        return 2;
+    }
+#endif
+
+    size_t messages = strtoull(argv[3], nullptr, 10);
+
+    if (messages == 0) {
+        std::cout << "Messages must be above 0" << std::endl;
+        print_usage();
+        return 3;
+    }
+
+    size_t payload = sizeof(uint64_t);
+    if (argc >= 5) {
+        payload = strtoull(argv[4], nullptr, 10);
+        if (payload < sizeof(uint64_t)) {
+            std::cout << "Payload must be at least " << sizeof(uint64_t) << " bytes" << std::endl;
+            print_usage();
+            return 4;
+        }
+    }
+
+    size_t iterations = 1;
+    if (argc == 6) {
+        iterations = strtoull(argv[5], nullptr, 10);
+        if (iterations == 0) {
+            std::cout << "Iterations must be above 0" << std::endl;
+            print_usage();
+            return 5;
+        }
+    }
+
+#ifdef SPSC
+    std::vector<SPSCQueue*> queues;
+    for (size_t i=0; i<producers; i++) {
+        queues.push_back(new SPSCQueue(payload));
+    }
+    std::cout << "Passing messages through " << producers << " SPSC queues." << std::endl;
+#endif
+
+#ifdef MPMC
+    std::vector<MPMCQueue*> queues;
+    queues.push_back(new MPMCQueue(payload));
+    std::cout << "Passing messages through one MPMC queue." << std::endl;
+#endif
+
+    // Each consumer sums the message ids it receives.
+    PaddedSum* sums = new PaddedSum[consumers];
+
+    // Threads 0 to producers - 1 produce and the rest consume. They are all
+    // running before the first iteration, and each one marks its
+    // own region of interest with its thread id so that gem5 can tell them
+    // apart.
+    SpinBarrier barrier(threads + 1);
+    std::vector<std::thread> thread_pool;
+    for (size_t i=0; i<threads; i++) {
+        thread_pool.emplace_back([&, i]() {
+            std::vector<uint8_t> message(payload);
+            for (size_t it=0; it<iterations; it++) {
+                barrier.wait();
+#ifdef GEM5
+                m5_work_begin(it, i);
+#endif
+                if (i < producers) {
+                    auto queue = queues[i % queues.size()];
+                    for (uint64_t id=0; id<messages; id++) {
+                        std::memset(message.data(), id, payload);
+                        std::memcpy(message.data(), &id, sizeof(id));
+                        while (!queue->push(message.data())) {
+                        }
+                    }
+                } else {
+                    size_t consumer = i - producers;
+                    auto queue = queues[consumer % queues.size()];
+                    // Split the messages evenly between the consumers.
+                    size_t total = producers * messages;
+                    size_t count = total / consumers + (consumer < total % consumers ? 1 : 0);
+#ifdef SPSC
+                    count = messages;
+#endif
+                    uint64_t sum = 0;
+                    for (size_t m=0; m<count; m++) {
+                        while (!queue->pop(message.data())) {
+                        }
+                        uint64_t id;
+                        std::memcpy(&id, message.data(), sizeof(id));
+                        sum += id;
+                    }
+                    sums[consumer].value = sum;
+                }
+#ifdef GEM5
+                m5_work_end(it, i);
+#endif
+                barrier.wait();
+            }
+        });
+    }
+
+    uint64_t expected = producers * (((uint64_t) messages) * (messages - 1) / 2);
+    double total_time = 0;
+    for (size_t it=0; it<iterations; it++) {
+        for (auto queue: queues) {
+            queue->reset();
+        }
+
+        std::cout << "Beginning to pass messages ..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+
+        barrier.wait();
+        barrier.wait();
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Done." << std::endl;
+        double time = std::chrono::duration<double, std::milli>(end - start).count();
+        total_time += time;
+        std::cout << "Time " << time << " ms (" << producers * messages / (time / 1e3) << " messages/s)" << std::endl;
+
+        uint64_t sum = 0;
+        for (size_t i=0; i<consumers; i++) {
+            sum += sums[i].value;
+        }
+        if (sum != expected) {
+            std::cout << "ERROR: RESULT WRONG!" << std::endl;
+            std::cout << "Expected " << expected << " got " << sum << std::endl;
+        }
+    }
+    if (iterations > 1) {
+        std::cout << "Average time " << total_time / iterations << " ms over " << iterations << " iterations" << std::endl;
+    }
+
+    for (auto &thread: thread_pool) {
+        thread.join();
+    }
+
+    for (auto queue: queues) {
+        delete queue;
+    }
+    delete[] sums;
+    return 0;
+}
@@ -24,23 +24,116 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+from typing import Optional
+
 import m5
 from gem5.simulate.exit_event import ExitEvent
 
 
-def handle_workbegin():
-    while True:
-        m5.stats.reset()
-        yield False
+class ROIManager:
+    """
+    Resets the stats at the first m5_work_begin of a region of interest and
+    dumps them at the last m5_work_end, so that regions of interest marked by
+    more than one thread (or nested inside each other) don't reset and dump
+    each other's stats.
+
+    gem5 only passes the workid of an m5_work_begin/m5_work_end as the exit
+    code, so the regions are counted per workid. The workid is read from the
+    simulator given to `set_simulator`. Without one, every marker counts
+    towards the same region.
+
+    :param dump_per_workid: Dump (and reset) the stats every time all of the
+        markers of a workid have ended, instead of only when every region has
+        ended. `dumped_workids` lists the workid of each stats dump in order.
+        The stats are only reset when no other workid is active, so when
+        workids overlap a dump also covers the part of the other regions
+        that ran since the last reset.
+    :param exit_after_rois: Exit the simulation after this many stats dumps.
+        `None` simulates until the workload exits.
+    :param recorder: A `RoiRecorder` (from src/bootcamp/roi_recorder) to hand
+        every marker to instead of resetting and dumping all of the stats.
+        It snapshots only the stats it was given and writes the regions out
+        in batches, which is much faster for many small regions. Every
+        region that ends then counts towards `exit_after_rois`.
+    """
+
+    def __init__(
+        self,
+        dump_per_workid: bool = False,
+        exit_after_rois: Optional[int] = 1,
+        recorder=None,
+    ):
+        self._dump_per_workid = dump_per_workid
+        self._exit_after_rois = exit_after_rois
+        self._recorder = recorder
+        self._simulator = None
+        # Number of m5_work_begin markers that haven't ended yet per workid.
+        self._active = {}
+        self.dumped_workids = []
+
+    def set_simulator(self, simulator) -> None:
+        self._simulator = simulator
+
+    def _get_workid(self):
+        if self._simulator is None:
+            return None
+        return self._simulator.get_last_exit_event_code()
+
+    def _dump(self, workid) -> bool:
+        if self._recorder is None:
+            m5.stats.dump()
+        self.dumped_workids.append(workid)
+        return (
+            self._exit_after_rois is not None
+            and len(self.dumped_workids) >= self._exit_after_rois
+        )
+
+    def handle_workbegin(self):
+        while True:
+            workid = self._get_workid()
+            if self._recorder is not None:
+                self._recorder.workBegin(workid or 0)
+            elif not self._active:
+                m5.stats.reset()
+            self._active[workid] = self._active.get(workid, 0) + 1
+            yield False
+
+    def handle_workend(self):
+        while True:
+            workid = self._get_workid()
+            if workid not in self._active:
+                # An end without a begin, e.g., the begin happened before we
+                # switched to this simulator.
+                yield False
+                continue
+            if self._recorder is not None:
+                self._recorder.workEnd(workid or 0)
+            self._active[workid] -= 1
+            if self._active[workid] > 0:
+                yield False
+                continue
+            del self._active[workid]
+            if self._recorder is not None:
+                yield self._dump(workid)
+            elif self._dump_per_workid:
+                done = self._dump(workid)
+                # Other workids that are still active keep counting from
+                # their own begin (or the last reset with none active).
+                if not self._active:
+                    m5.stats.reset()
+                yield done
+            elif not self._active:
+                yield self._dump(workid)
+            else:
+                yield False
 
+    def exit_event_handler(self) -> dict:
+        return {
+            ExitEvent.WORKBEGIN: self.handle_workbegin(),
+            ExitEvent.WORKEND: self.handle_workend(),
+        }
 
-def handle_workend():
-    while True:
-        m5.stats.dump()
-        yield True
 
+roi_manager = ROIManager()
 
-exit_event_handler = {
-    ExitEvent.WORKBEGIN: handle_workbegin(),
-    ExitEvent.WORKEND: handle_workend(),
-}
+exit_event_handler = roi_manager.exit_event_handler()
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2022 The Regents of the University of California
+ * All rights reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The matrix multiply kernels for one element type. matrix-multiply.c
+ * includes this file once per type with ELEM set to the type and SUFFIX to
+ * the suffix of the function names. If the target has vector instructions
+ * for the type it also defines SIMD_VEC, SIMD_ZERO, SIMD_LOAD, SIMD_STORE
+ * and SIMD_MAC (acc + a * b with a broadcast), and either SIMD_WIDTH for
+ * fixed width vectors or SIMD_SETVL for RISC-V's variable length ones.
+ */
+
+#define MM_CAT_(a, b) a##_##b
+#define MM_CAT(a, b) MM_CAT_(a, b)
+#define MM_FN(name) MM_CAT(name, SUFFIX)
+#define MM_STR_(x) #x
+#define MM_STR(x) MM_STR_(x)
+
+/* The original i-j-k loop. The k loop walks down a column of second. */
+static void MM_FN(mm_naive)(struct mm_args *args)
+{
+    const int size = args->size;
+    const ELEM *first = (const ELEM *) args->first;
+    const ELEM *second = (const ELEM *) args->second;
+    ELEM *multiply = (ELEM *) args->multiply;
+    for(int c=args->row_begin; c<args->row_end; c++)
+    {
+        for(int d=0; d<size; d++)
+        {
+            ELEM sum = 0;
+            for(int k=0; k<size; k++)
+            {
+                sum += first[(size_t) c * size + k] * second[(size_t) k * size + d];
+            }
+            multiply[(size_t) c * size + d] = sum;
+        }
+    }
+}
+
+/*
+ * i-k-j order. The inner loop walks along a row of second and of multiply,
+ * so every access is sequential.
+ */
+static void MM_FN(mm_interchange)(struct mm_args *args)
+{
+    const int size = args->size;
+    const ELEM *first = (const ELEM *) args->first;
+    const ELEM *second = (const ELEM *) args->second;
+    ELEM *multiply = (ELEM *) args->multiply;
+    for(int c=args->row_begin; c<args->row_end; c++)
+    {
+        ELEM *row = &multiply[(size_t) c * size];
+        for(int d=0; d<size; d++)
+            row[d] = 0;
+        for(int k=0; k<size; k++)
+        {
+            ELEM a = first[(size_t) c * size + k];
+            const ELEM *second_row = &second[(size_t) k * size];
+            for(int d=0; d<size; d++)
+            {
+                row[d] += a * second_row[d];
+            }
+        }
+    }
+}
+
+/*
+ * i-k-j order, tiled twice over k and j. An l2_tile x l2_tile block of
+ * second is reused for every row before moving on, and inside of it an
+ * l1_tile x l1_tile block.
+ */
+static void MM_FN(mm_tiled)(struct mm_args *args)
+{
+    const int size = args->size;
+    const int l1 = args->l1_tile;
+    const int l2 = args->l2_tile;
+    const ELEM *first = (const ELEM *) args->first;
+    const ELEM *second = (const ELEM *) args->second;
+    ELEM *multiply = (ELEM *) args->multiply;
+    for(int c=args->row_begin; c<args->row_end; c++)
+        for(int d=0; d<size; d++)
+            multiply[(size_t) c * size + d] = 0;
+
+    for(int k2=0; k2<size; k2+=l2)
+    {
+        int k2_end = min_int(k2 + l2, size);
+        for(int d2=0; d2<size; d2+=l2)
+        {
+            int d2_end = min_int(d2 + l2, size);
+            for(int k1=k2; k1<k2_end; k1+=l1)
+            {
+                int k1_end = min_int(k1 + l1, k2_end);
+                for(int d1=d2; d1<d2_end; d1+=l1)
+                {
+                    int d1_end = min_int(d1 + l1, d2_end);
+                    for(int c=args->row_begin; c<args->row_end; c++)
+                    {
+                        ELEM *row = &multiply[(size_t) c * size];
+                        for(int k=k1; k<k1_end; k++)
+                        {
+                            ELEM a = first[(size_t) c * size + k];
+                            const ELEM *second_row = &second[(size_t) k * size];
+                            for(int d=d1; d<d1_end; d++)
+                            {
+                                row[d] += a * second_row[d];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Register blocked micro-kernel. It keeps an MR row by two vector wide block
+ * of multiply in registers for the whole k loop, so each vector of second
+ * that it loads is used MR times. The rows and columns left over at the
+ * edges are done by scalar loops.
+ */
+static void MM_FN(mm_simd)(struct mm_args *args)
+{
+    const int size = args->size;
+    const ELEM *first = (const ELEM *) args->first;
+    const ELEM *second = (const ELEM *) args->second;
+    ELEM *multiply = (ELEM *) args->multiply;
+    int c = args->row_begin;
+    for(; c + MR <= args->row_end; c += MR)
+    {
+        const ELEM *a_rows = &first[(size_t) c * size];
+        ELEM *c_rows = &multiply[(size_t) c * size];
+        int d = 0;
+#if defined(SIMD_WIDTH)
+        for(; d + 2 * SIMD_WIDTH <= size; d += 2 * SIMD_WIDTH)
+        {
+            SIMD_VEC acc[MR][2];
+            for(int r=0; r<MR; r++)
+            {
+                acc[r][0] = SIMD_ZERO();
+                acc[r][1] = SIMD_ZERO();
+            }
+            for(int k=0; k<size; k++)
+            {
+                SIMD_VEC b0 = SIMD_LOAD(&second[(size_t) k * size + d]);
+                SIMD_VEC b1 = SIMD_LOAD(&second[(size_t) k * size + d + SIMD_WIDTH]);
+                for(int r=0; r<MR; r++)
+                {
+                    ELEM a = a_rows[(size_t) r * size + k];
+                    acc[r][0] = SIMD_MAC(acc[r][0], a, b0);
+                    acc[r][1] = SIMD_MAC(acc[r][1], a, b1);
+                }
+            }
+            for(int r=0; r<MR; r++)
+            {
+                SIMD_STORE(&c_rows[(size_t) r * size + d], acc[r][0]);
+                SIMD_STORE(&c_rows[(size_t) r * size + d + SIMD_WIDTH], acc[r][1]);
+            }
+        }
+#elif defined(SIMD_SETVL)
+        /*
+         * The vector length handles the columns left over at the edge. RVV
+         * types are sizeless and can't go in an array, so the MR (4) rows
+         * are unrolled by hand.
+         */
+        for(size_t vl; d < size; d += vl)
+        {
+            vl = SIMD_SETVL(size - d);
+            SIMD_VEC acc0 = SIMD_ZERO(vl);
+            SIMD_VEC acc1 = SIMD_ZERO(vl);
+            SIMD_VEC acc2 = SIMD_ZERO(vl);
+            SIMD_VEC acc3 = SIMD_ZERO(vl);
+            for(int k=0; k<size; k++)
+            {
+                SIMD_VEC b = SIMD_LOAD(&second[(size_t) k * size + d], vl);
+                acc0 = SIMD_MAC(acc0, a_rows[k], b, vl);
+                acc1 = SIMD_MAC(acc1, a_rows[(size_t) size + k], b, vl);
+                acc2 = SIMD_MAC(acc2, a_rows[(size_t) 2 * size + k], b, vl);
+                acc3 = SIMD_MAC(acc3, a_rows[(size_t) 3 * size + k], b, vl);
+            }
+            SIMD_STORE(&c_rows[d], acc0, vl);
+            SIMD_STORE(&c_rows[(size_t) size + d], acc1, vl);
+            SIMD_STORE(&c_rows[(size_t) 2 * size + d], acc2, vl);
+            SIMD_STORE(&c_rows[(size_t) 3 * size + d], acc3, vl);
+        }
+#endif
+        for(; d<size; d++)
+        {
+            for(int r=0; r<MR; r++)
+            {
+                ELEM sum = 0;
+                for(int k=0; k<size; k++)
+                    sum += a_rows[(size_t) r * size + k] * second[(size_t) k * size + d];
+                c_rows[(size_t) r * size + d] = sum;
+            }
+        }
+    }
+    struct mm_args rest = *args;
+    rest.row_begin = c;
+    MM_FN(mm_interchange)(&rest);
+}
+
+/*
+ * Small values so that no element can overflow an int32 or lose precision in
+ * a float for any size we can simulate, and every variant gets the same sum.
+ */
+static void MM_FN(mm_init)(void *first_ptr, void *second_ptr, int size)
+{
+    ELEM *first = (ELEM *) first_ptr;
+    ELEM *second = (ELEM *) second_ptr;
+    for(int x=0; x<size; x++)
+    {
+        for(int y=0; y<size; y++)
+        {
+            first[(size_t) x * size + y] = (x + y) % 16;
+            second[(size_t) x * size + y] = ((4 * x) + (7 * y)) % 16;
+        }
+    }
+}
+
+static double MM_FN(mm_sum)(const void *multiply_ptr, int size)
+{
+    const ELEM *multiply = (const ELEM *) multiply_ptr;
+    double sum = 0;
+    for(size_t i=0; i<(size_t) size * size; i++)
+        sum += multiply[i];
+    return sum;
+}
+
+static struct mm_type MM_FN(mm_type) = {
+    MM_STR(SUFFIX),
+    sizeof(ELEM),
+    {MM_FN(mm_naive), MM_FN(mm_interchange), MM_FN(mm_tiled), MM_FN(mm_simd)},
+    MM_FN(mm_init),
+    MM_FN(mm_sum),
+};
+
+#undef MM_CAT_
+#undef MM_CAT
+#undef MM_FN
+#undef MM_STR_
+#undef MM_STR
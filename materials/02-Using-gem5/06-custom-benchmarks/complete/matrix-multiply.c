@@ -26,49 +26,396 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__riscv_vector)
+#include <riscv_vector.h>
+#endif
+
+#ifdef GEM5
 #include <gem5/m5ops.h>
+#endif
+
+/* Matrices start on a cache block so that vector loads don't split blocks. */
+#define ALIGNMENT 64
+
+/* Rows of multiply computed at once by the simd micro-kernel. */
+#define MR 4
 
-int main()
+/*
+ * Every variant computes the rows [row_begin, row_end) of
+ * multiply = first * second. All matrices are size x size, stored row major.
+ */
+struct mm_args
 {
-    const int size = 100;
-    int first[size][size], second[size][size], multiply[size][size];
+    const void *first;
+    const void *second;
+    void *multiply;
+    int size;
+    int row_begin;
+    int row_end;
+    int l1_tile;
+    int l2_tile;
+    void (*kernel)(struct mm_args *);
+};
 
-    printf("Populating the first and second matrix...\n");
-    for(int x=0; x<size; x++)
+enum mm_variant
+{
+    VARIANT_NAIVE,
+    VARIANT_INTERCHANGE,
+    VARIANT_TILED,
+    VARIANT_SIMD,
+    NUM_VARIANTS
+};
+
+static const char *variant_names[NUM_VARIANTS] = {"naive", "interchange", "tiled", "simd"};
+
+/* The kernels and helpers for one element type. */
+struct mm_type
+{
+    const char *name;
+    size_t elem_size;
+    void (*kernels[NUM_VARIANTS])(struct mm_args *);
+    void (*init)(void *first, void *second, int size);
+    double (*sum)(const void *multiply, int size);
+};
+
+static int min_int(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+#define ELEM int32_t
+#define SUFFIX int32
+#if defined(__AVX2__)
+#define SIMD_WIDTH 8
+#define SIMD_VEC __m256i
+#define SIMD_ZERO() _mm256_setzero_si256()
+#define SIMD_LOAD(p) _mm256_loadu_si256((const __m256i *) (p))
+#define SIMD_STORE(p, v) _mm256_storeu_si256((__m256i *) (p), v)
+#define SIMD_MAC(acc, a, b) _mm256_add_epi32(acc, _mm256_mullo_epi32(_mm256_set1_epi32(a), b))
+#elif defined(__ARM_NEON)
+#define SIMD_WIDTH 4
+#define SIMD_VEC int32x4_t
+#define SIMD_ZERO() vdupq_n_s32(0)
+#define SIMD_LOAD(p) vld1q_s32(p)
+#define SIMD_STORE(p, v) vst1q_s32(p, v)
+#define SIMD_MAC(acc, a, b) vmlaq_n_s32(acc, b, a)
+#elif defined(__riscv_vector)
+#define SIMD_SETVL(n) __riscv_vsetvl_e32m2(n)
+#define SIMD_VEC vint32m2_t
+#define SIMD_ZERO(vl) __riscv_vmv_v_x_i32m2(0, vl)
+#define SIMD_LOAD(p, vl) __riscv_vle32_v_i32m2(p, vl)
+#define SIMD_STORE(p, v, vl) __riscv_vse32_v_i32m2(p, v, vl)
+#define SIMD_MAC(acc, a, b, vl) __riscv_vmacc_vx_i32m2(acc, a, b, vl)
+#endif
+#include "matrix-multiply-kernels.h"
+#undef ELEM
+#undef SUFFIX
+#undef SIMD_WIDTH
+#undef SIMD_SETVL
+#undef SIMD_VEC
+#undef SIMD_ZERO
+#undef SIMD_LOAD
+#undef SIMD_STORE
+#undef SIMD_MAC
+
+#define ELEM float
+#define SUFFIX float
+#if defined(__AVX2__)
+#define SIMD_WIDTH 8
+#define SIMD_VEC __m256
+#define SIMD_ZERO() _mm256_setzero_ps()
+#define SIMD_LOAD(p) _mm256_loadu_ps(p)
+#define SIMD_STORE(p, v) _mm256_storeu_ps(p, v)
+#define SIMD_MAC(acc, a, b) _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(a), b))
+#elif defined(__ARM_NEON)
+#define SIMD_WIDTH 4
+#define SIMD_VEC float32x4_t
+#define SIMD_ZERO() vdupq_n_f32(0)
+#define SIMD_LOAD(p) vld1q_f32(p)
+#define SIMD_STORE(p, v) vst1q_f32(p, v)
+#define SIMD_MAC(acc, a, b) vmlaq_n_f32(acc, b, a)
+#elif defined(__riscv_vector)
+#define SIMD_SETVL(n) __riscv_vsetvl_e32m2(n)
+#define SIMD_VEC vfloat32m2_t
+#define SIMD_ZERO(vl) __riscv_vfmv_v_f_f32m2(0, vl)
+#define SIMD_LOAD(p, vl) __riscv_vle32_v_f32m2(p, vl)
+#define SIMD_STORE(p, v, vl) __riscv_vse32_v_f32m2(p, v, vl)
+#define SIMD_MAC(acc, a, b, vl) __riscv_vfmacc_vf_f32m2(acc, a, b, vl)
+#endif
+#include "matrix-multiply-kernels.h"
+#undef ELEM
+#undef SUFFIX
+#undef SIMD_WIDTH
+#undef SIMD_SETVL
+#undef SIMD_VEC
+#undef SIMD_ZERO
+#undef SIMD_LOAD
+#undef SIMD_STORE
+#undef SIMD_MAC
+
+#define ELEM double
+#define SUFFIX double
+#if defined(__AVX2__)
+#define SIMD_WIDTH 4
+#define SIMD_VEC __m256d
+#define SIMD_ZERO() _mm256_setzero_pd()
+#define SIMD_LOAD(p) _mm256_loadu_pd(p)
+#define SIMD_STORE(p, v) _mm256_storeu_pd(p, v)
+#define SIMD_MAC(acc, a, b) _mm256_add_pd(acc, _mm256_mul_pd(_mm256_set1_pd(a), b))
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SIMD_WIDTH 2
+#define SIMD_VEC float64x2_t
+#define SIMD_ZERO() vdupq_n_f64(0)
+#define SIMD_LOAD(p) vld1q_f64(p)
+#define SIMD_STORE(p, v) vst1q_f64(p, v)
+#define SIMD_MAC(acc, a, b) vfmaq_n_f64(acc, b, a)
+#elif defined(__riscv_vector)
+#define SIMD_SETVL(n) __riscv_vsetvl_e64m2(n)
+#define SIMD_VEC vfloat64m2_t
+#define SIMD_ZERO(vl) __riscv_vfmv_v_f_f64m2(0, vl)
+#define SIMD_LOAD(p, vl) __riscv_vle64_v_f64m2(p, vl)
+#define SIMD_STORE(p, v, vl) __riscv_vse64_v_f64m2(p, v, vl)
+#define SIMD_MAC(acc, a, b, vl) __riscv_vfmacc_vf_f64m2(acc, a, b, vl)
+#endif
+#include "matrix-multiply-kernels.h"
+#undef ELEM
+#undef SUFFIX
+#undef SIMD_WIDTH
+#undef SIMD_SETVL
+#undef SIMD_VEC
+#undef SIMD_ZERO
+#undef SIMD_LOAD
+#undef SIMD_STORE
+#undef SIMD_MAC
+
+static struct mm_type *types[] = {&mm_type_int32, &mm_type_float, &mm_type_double};
+
+/*
+ * Barrier that spins (yielding) until the last thread arrives, so that
+ * releasing the threads doesn't depend on the OS or on gem5's syscall
+ * emulation. The last thread to arrive bumps the generation.
+ */
+struct spin_barrier
+{
+    int threads;
+    int count;
+    int generation;
+};
+
+static void spin_barrier_init(struct spin_barrier *barrier, int threads)
+{
+    barrier->threads = threads;
+    barrier->count = 0;
+    barrier->generation = 0;
+}
+
+static void spin_barrier_wait(struct spin_barrier *barrier)
+{
+    int generation = __atomic_load_n(&barrier->generation, __ATOMIC_ACQUIRE);
+    if (__atomic_add_fetch(&barrier->count, 1, __ATOMIC_ACQ_REL) == barrier->threads)
     {
-        for(int y=0; y<size; y++)
-        {
-            first[x][y] = x + y;
-            second[x][y] = (4 * x) + (7 * y);
-        }
+        __atomic_store_n(&barrier->count, 0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&barrier->generation, 1, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (__atomic_load_n(&barrier->generation, __ATOMIC_ACQUIRE) == generation)
+            sched_yield();
     }
+}
+
+/* A worker thread's rows and the barrier around the multiply. */
+struct mm_worker
+{
+    struct mm_args *args;
+    struct spin_barrier *barrier;
+};
+
+static void *mm_thread(void *arg)
+{
+    struct mm_worker *worker = (struct mm_worker *) arg;
+    spin_barrier_wait(worker->barrier);
+    worker->args->kernel(worker->args);
+    spin_barrier_wait(worker->barrier);
+    return NULL;
+}
+
+static void *alloc_matrix(int size, size_t elem_size)
+{
+    size_t bytes = (size_t) size * size * elem_size;
+    return aligned_alloc(ALIGNMENT, (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+}
+
+/*
+ * Multiplies two size x size matrices with the given kernel, split over the
+ * threads, inside region of interest workid.
+ */
+static int run(struct mm_type *type, enum mm_variant variant, int size, int threads,
+               int l1_tile, int l2_tile, int workid)
+{
+    void *first = alloc_matrix(size, type->elem_size);
+    void *second = alloc_matrix(size, type->elem_size);
+    void *multiply = alloc_matrix(size, type->elem_size);
+    if (first == NULL || second == NULL || multiply == NULL)
+    {
+        printf("Could not allocate three %dx%d %s matrices\n", size, size, type->name);
+        return 1;
+    }
+
+    printf("Populating the first and second matrix...\n");
+    type->init(first, second, size);
     printf("Done!\n");
 
-    printf("Multiplying the matrixes...\n");
-    m5_work_begin(0, 0);
-    for(int c=0; c<size; c++)
+    /* Split the rows into blocks, one for each thread. */
+    struct mm_args args[threads];
+    for(int t=0; t<threads; t++)
     {
-        for(int d=0; d<size; d++)
-        {
-            int sum = 0;
-            for(int k=0; k<size; k++)
-            {
-                sum += first[c][k] * second[k][d];
-            }
-           multiply[c][d] = sum;
-        }
+        args[t].first = first;
+        args[t].second = second;
+        args[t].multiply = multiply;
+        args[t].size = size;
+        args[t].row_begin = (int) ((long) size * t / threads);
+        args[t].row_end = (int) ((long) size * (t + 1) / threads);
+        args[t].l1_tile = l1_tile;
+        args[t].l2_tile = l2_tile;
+        args[t].kernel = type->kernels[variant];
     }
-    m5_work_end(0, 0);
+
+    /*
+     * Start the workers before the region of interest, so that it only
+     * holds the multiply and not the thread creation. They wait at the
+     * barrier until the main thread joins them in the region.
+     */
+    struct spin_barrier barrier;
+    spin_barrier_init(&barrier, threads);
+    struct mm_worker worker_args[threads];
+    pthread_t workers[threads];
+    for(int t=1; t<threads; t++)
+    {
+        worker_args[t].args = &args[t];
+        worker_args[t].barrier = &barrier;
+        pthread_create(&workers[t], NULL, mm_thread, &worker_args[t]);
+    }
+
+    printf("Multiplying the %dx%d %s matrixes (%s, %d threads)...\n",
+           size, size, type->name, variant_names[variant], threads);
+#ifdef GEM5
+    m5_work_begin(workid, 0);
+#else
+    (void) workid;
+#endif
+    spin_barrier_wait(&barrier);
+    args[0].kernel(&args[0]);
+    spin_barrier_wait(&barrier);
+#ifdef GEM5
+    m5_work_end(workid, 0);
+#endif
+    for(int t=1; t<threads; t++)
+        pthread_join(workers[t], NULL);
     printf("Done!\n");
 
     printf("Calculating the sum of all elements in the matrix...\n");
-    long int sum = 0;
-    for(int x=0; x<size; x++)
-        for(int y=0; y<size; y++)
-            sum += multiply[x][y];
+    double sum = type->sum(multiply, size);
     printf("Done\n");
 
-    printf("The sum is %ld\n", sum);
+    printf("The sum is %.0f\n", sum);
+
+    free(first);
+    free(second);
+    free(multiply);
+    return 0;
+}
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [--variant naive|interchange|tiled|simd] [--threads N]\n"
+           "          [--l1-tile B] [--l2-tile B] [--size N] [--type int32|float|double]\n"
+           "          [--sweep] [--min-size N] [--max-size N]\n", name);
+    printf("The tiles only apply to the tiled variant. The rows are split\n"
+           "evenly between the threads.\n");
+    printf("--sweep multiplies matrices of every power of two size from --min-size\n"
+           "(16) to --max-size (512), each in its own region of interest with the\n"
+           "size's index as the workid.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int size = 100;
+    const char *variant_name = "naive";
+    const char *type_name = "int32";
+    int threads = 1;
+    int l1_tile = 32;
+    int l2_tile = 128;
+    int sweep = 0;
+    int min_size = 16;
+    int max_size = 512;
+    static struct option options[] = {
+        {"variant", required_argument, NULL, 'v'},
+        {"threads", required_argument, NULL, 't'},
+        {"l1-tile", required_argument, NULL, '1'},
+        {"l2-tile", required_argument, NULL, '2'},
+        {"size", required_argument, NULL, 's'},
+        {"type", required_argument, NULL, 'T'},
+        {"sweep", no_argument, NULL, 'S'},
+        {"min-size", required_argument, NULL, 'm'},
+        {"max-size", required_argument, NULL, 'M'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "v:t:s:h", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+          case 'v': variant_name = optarg; break;
+          case 't': threads = atoi(optarg); break;
+          case '1': l1_tile = atoi(optarg); break;
+          case '2': l2_tile = atoi(optarg); break;
+          case 's': size = atoi(optarg); break;
+          case 'T': type_name = optarg; break;
+          case 'S': sweep = 1; break;
+          case 'm': min_size = atoi(optarg); break;
+          case 'M': max_size = atoi(optarg); break;
+          default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    int variant = -1;
+    for(int v=0; v<NUM_VARIANTS; v++)
+        if (strcmp(variant_name, variant_names[v]) == 0)
+            variant = v;
+    struct mm_type *type = NULL;
+    for(size_t t=0; t<sizeof(types) / sizeof(types[0]); t++)
+        if (strcmp(type_name, types[t]->name) == 0)
+            type = types[t];
+    if (variant < 0 || type == NULL || threads < 1 || l1_tile < 1 || l2_tile < 1 ||
+        size < 1 || min_size < 1 || max_size < min_size)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!sweep)
+        return run(type, (enum mm_variant) variant, size, threads, l1_tile, l2_tile, 0);
+
+    int workid = 0;
+    for(long s=min_size; s<=max_size; s*=2, workid++)
+    {
+        int ret = run(type, (enum mm_variant) variant, (int) s, threads, l1_tile, l2_tile, workid);
+        if (ret != 0)
+            return ret;
+    }
+    return 0;
 }
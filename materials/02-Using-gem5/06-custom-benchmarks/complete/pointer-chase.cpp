@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2024 The Regents of the University of California
+ * All rights reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Measures load-to-use latency in the style of lmbench's lat_mem_rd. For
+ * each footprint it links the buffer into one cyclic list, one node every
+ * stride bytes, and follows it. Every load depends on the one before, so
+ * neither out of order execution nor the prefetchers can hide the latency,
+ * and the time per load is the latency of whichever level the footprint
+ * fits in.
+ *
+ * By default the list visits the nodes in a random order. With --sequential
+ * it visits them in address order, which is what lat_mem_rd does and lets
+ * the prefetchers help.
+ *
+ * Each footprint is chased inside its own region of interest with the
+ * footprint's index as the workid.
+ */
+
+#include <getopt.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#ifdef GEM5
+#include <gem5/m5ops.h>
+#endif
+
+/* Alignment of the buffer with --huge-pages, one 2 MiB X86/Arm/RISC-V page. */
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+/* Loads in one iteration of the chasing loop. */
+#define UNROLL 8
+
+/*
+ * Links the nodes of buffer, one every stride bytes, into a single cycle and
+ * returns its first node. Each node holds the address of the next one.
+ */
+static char **build_cycle(char *buffer, size_t size, size_t stride, bool sequential,
+                          std::mt19937_64 &rng)
+{
+    size_t nodes = size / stride;
+    std::vector<size_t> order(nodes);
+    std::iota(order.begin(), order.end(), 0);
+    if (!sequential)
+        std::shuffle(order.begin() + 1, order.end(), rng);
+    for(size_t i=0; i<nodes; i++)
+    {
+        char **node = (char **) (buffer + order[i] * stride);
+        *node = buffer + order[(i + 1) % nodes] * stride;
+    }
+    return (char **) buffer;
+}
+
+#define CHASE_ONE p = (char **) *p;
+
+/* Follows the cycle for loads loads (a multiple of UNROLL). */
+__attribute__((noinline)) static char **chase(char **p, size_t loads)
+{
+    for(size_t i=0; i<loads; i+=UNROLL)
+    {
+        CHASE_ONE CHASE_ONE CHASE_ONE CHASE_ONE
+        CHASE_ONE CHASE_ONE CHASE_ONE CHASE_ONE
+    }
+    return p;
+}
+
+static char *alloc_buffer(size_t size, bool huge_pages)
+{
+    if (!huge_pages)
+        return (char *) aligned_alloc(64, (size + 63) / 64 * 64);
+
+    /*
+     * Ask for transparent huge pages so that the random walk doesn't also
+     * measure TLB misses once the footprint is larger than the TLB's reach.
+     * This is only a hint, gem5's syscall emulation ignores it.
+     */
+    size_t bytes = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    char *buffer = (char *) aligned_alloc(HUGE_PAGE_SIZE, bytes);
+#ifdef MADV_HUGEPAGE
+    if (buffer != NULL && madvise(buffer, bytes, MADV_HUGEPAGE) != 0)
+        fprintf(stderr, "Warning: could not get huge pages, continuing without\n");
+#endif
+    return buffer;
+}
+
+/* Sizes like 4096, 32k, 8M or 1G. */
+static size_t parse_size(const char *text)
+{
+    char *end;
+    size_t size = strtoull(text, &end, 10);
+    switch (*end)
+    {
+      case 'k': case 'K': return size << 10;
+      case 'm': case 'M': return size << 20;
+      case 'g': case 'G': return size << 30;
+      default: return size;
+    }
+}
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [--min-size B] [--max-size B] [--size B] [--stride B]\n"
+           "          [--loads N] [--sequential] [--huge-pages]\n", name);
+    printf("Chases pointers through every footprint from --min-size (4k) to\n"
+           "--max-size (64M), two per power of two, or just --size. Sizes can end\n"
+           "in k, M or G. Nodes are --stride (64) bytes apart and each footprint\n"
+           "does --loads (1M) timed loads after one untimed pass to warm it up.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t min_size = 4 << 10;
+    size_t max_size = 64 << 20;
+    size_t stride = 64;
+    size_t loads = 1 << 20;
+    bool sequential = false;
+    bool huge_pages = false;
+    static struct option options[] = {
+        {"min-size", required_argument, NULL, 'm'},
+        {"max-size", required_argument, NULL, 'M'},
+        {"size", required_argument, NULL, 's'},
+        {"stride", required_argument, NULL, 'S'},
+        {"loads", required_argument, NULL, 'n'},
+        {"sequential", no_argument, NULL, 'q'},
+        {"huge-pages", no_argument, NULL, 'H'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:n:h", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+          case 'm': min_size = parse_size(optarg); break;
+          case 'M': max_size = parse_size(optarg); break;
+          case 's': min_size = max_size = parse_size(optarg); break;
+          case 'S': stride = parse_size(optarg); break;
+          case 'n': loads = parse_size(optarg); break;
+          case 'q': sequential = true; break;
+          case 'H': huge_pages = true; break;
+          default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (stride < sizeof(char *) || stride % sizeof(char *) != 0 ||
+        min_size < 2 * stride || max_size < min_size || loads == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    loads = (loads + UNROLL - 1) / UNROLL * UNROLL;
+
+    /* Powers of two and the sizes half way between them. */
+    std::vector<size_t> sizes;
+    for(size_t s=min_size; s<=max_size; s*=2)
+    {
+        sizes.push_back(s);
+        if (s + s / 2 <= max_size && s != max_size)
+            sizes.push_back(s + s / 2);
+    }
+
+    std::mt19937_64 rng(0x9e3779b97f4a7c15ULL);
+    char *buffer = alloc_buffer(max_size, huge_pages);
+    if (buffer == NULL)
+    {
+        printf("Could not allocate %zu bytes\n", max_size);
+        return 1;
+    }
+
+    printf("stride=%zu loads=%zu %s%s\n", stride, loads,
+           sequential ? "sequential" : "random", huge_pages ? " huge-pages" : "");
+    printf("%12s %10s\n", "size (KiB)", "ns/load");
+    size_t sink = 0;
+    for(size_t workid=0; workid<sizes.size(); workid++)
+    {
+        size_t size = sizes[workid];
+        char **p = build_cycle(buffer, size, stride, sequential, rng);
+        p = chase(p, (size / stride + UNROLL - 1) / UNROLL * UNROLL);
+
+        auto start = std::chrono::steady_clock::now();
+#ifdef GEM5
+        m5_work_begin(workid, 0);
+#endif
+        p = chase(p, loads);
+#ifdef GEM5
+        m5_work_end(workid, 0);
+#endif
+        auto end = std::chrono::steady_clock::now();
+
+        sink += (char *) p - buffer;
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        printf("%12.2f %10.2f\n", size / 1024.0, ns / loads);
+    }
+    /* Use where the chasing ended so the compiler can't drop it. */
+    printf("Sum of the final offsets: %zu\n", sink);
+
+    free(buffer);
+    return 0;
+}
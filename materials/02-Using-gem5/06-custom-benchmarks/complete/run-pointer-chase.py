@@ -0,0 +1,121 @@
+"""
+This script runs the pointer chasing latency benchmark in gem5 and prints
+the load-to-use latency for each footprint.
+
+The benchmark chases pointers through each footprint inside its own region
+of interest. The script records the tick at the start of each region and
+divides the ticks spent in it by the number of loads, so the latencies come
+from the simulated time rather than from the (emulated) clock in the
+benchmark.
+
+To measure another cache hierarchy or memory, such as the three level
+hierarchy from 04-cache-hierarchies or a secure memory, swap it in below and
+compare the latencies of the footprints that fit in each level.
+
+$ gem5 run-pointer-chase.py --max-size 4M
+
+prints one "Footprint <index>: <latency> ns/load" line per footprint, from
+the smallest to the largest. The script runs the x86 pointer-chase binary
+next to it, which is built from the current pointer-chase.cpp. Run
+`make pointer-chase` to rebuild it after changing the benchmark.
+"""
+
+import argparse
+
+import m5
+
+from gem5.components.boards.simple_board import SimpleBoard
+from gem5.components.processors.simple_processor import SimpleProcessor
+from gem5.components.cachehierarchies.classic.private_l1_shared_l2_cache_hierarchy import (
+    PrivateL1SharedL2CacheHierarchy,
+)
+from gem5.components.memory.single_channel import SingleChannelDDR4_2400
+from gem5.components.processors.cpu_types import CPUTypes
+from gem5.isas import ISA
+from gem5.resources.resource import BinaryResource
+from gem5.simulate.simulator import Simulator, ExitEvent
+
+parser = argparse.ArgumentParser()
+parser.add_argument("--min-size", default="4k", help="Smallest footprint")
+parser.add_argument("--max-size", default="2M", help="Largest footprint")
+parser.add_argument("--stride", default="64", help="Bytes between nodes")
+parser.add_argument(
+    "--loads", type=int, default=100000, help="Timed loads per footprint"
+)
+parser.add_argument(
+    "--sequential",
+    action="store_true",
+    help="Visit the nodes in address order instead of a random one",
+)
+args = parser.parse_args()
+
+cache_hierarchy = PrivateL1SharedL2CacheHierarchy(
+    l1d_size="64kB",
+    l1i_size="64kB",
+    l2_size="1MB",
+)
+
+# Setup the system memory.
+memory = SingleChannelDDR4_2400()
+
+# A timing CPU waits for every load, so the time per load is the latency of
+# the memory system.
+processor = SimpleProcessor(cpu_type=CPUTypes.TIMING, isa=ISA.X86, num_cores=1)
+
+board = SimpleBoard(
+    clk_freq="3GHz",
+    processor=processor,
+    memory=memory,
+    cache_hierarchy=cache_hierarchy,
+)
+
+arguments = [
+    "--min-size",
+    args.min_size,
+    "--max-size",
+    args.max_size,
+    "--stride",
+    args.stride,
+    "--loads",
+    str(args.loads),
+]
+if args.sequential:
+    arguments.append("--sequential")
+
+board.set_se_binary_workload(
+    binary=BinaryResource(local_path="pointer-chase"),
+    arguments=arguments,
+)
+
+# The benchmark rounds the loads up to a multiple of its unrolling.
+loads = (args.loads + 7) // 8 * 8
+begin_ticks = []
+
+
+def workbegin_handler():
+    while True:
+        m5.stats.reset()
+        begin_ticks.append(m5.curTick())
+        yield False
+
+
+def workend_handler():
+    while True:
+        ticks = m5.curTick() - begin_ticks[-1]
+        # Ticks are picoseconds.
+        print(
+            f"Footprint {len(begin_ticks) - 1}: "
+            f"{ticks / 1000 / loads:.2f} ns/load"
+        )
+        m5.stats.dump()
+        yield False
+
+
+simulator = Simulator(
+    board=board,
+    on_exit_event={
+        ExitEvent.WORKBEGIN: workbegin_handler(),
+        ExitEvent.WORKEND: workend_handler(),
+    },
+)
+simulator.run()
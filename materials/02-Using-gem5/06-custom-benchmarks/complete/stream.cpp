@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2024 The Regents of the University of California
+ * All rights reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sustainable memory bandwidth in the style of John McCalpin's STREAM. It
+ * times four kernels over arrays much larger than the caches:
+ *
+ *   copy   c = a
+ *   scale  b = s * c
+ *   add    c = a + b
+ *   triad  a = b + s * c
+ *
+ * The arrays are split evenly between the threads. Each run of each kernel
+ * is its own region of interest with workid iteration * 4 + kernel.
+ *
+ * Like STREAM, the bandwidth counts the bytes the kernel reads and writes
+ * and not the extra reads that write allocate caches do for the stores.
+ * --nt-stores uses non-temporal stores that skip those reads. Only X86 has
+ * them here; other ISAs fall back to ordinary stores.
+ */
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_NT_STORES 1
+#else
+#define HAVE_NT_STORES 0
+#endif
+
+#ifdef GEM5
+#include <gem5/m5ops.h>
+#endif
+
+/* Arrays and each thread's part of them start on a cache block. */
+#define ALIGNMENT 64
+#define BLOCK_ELEMS (ALIGNMENT / sizeof(double))
+
+#define SCALAR 3.0
+
+enum stream_kernel
+{
+    KERNEL_COPY,
+    KERNEL_SCALE,
+    KERNEL_ADD,
+    KERNEL_TRIAD,
+    NUM_KERNELS
+};
+
+static const char *kernel_names[NUM_KERNELS] = {"copy", "scale", "add", "triad"};
+
+/* Arrays each kernel touches, to turn its time into bandwidth. */
+static const int kernel_arrays[NUM_KERNELS] = {2, 2, 3, 3};
+
+/*
+ * Lines the threads up before and after every kernel. Each arrival bumps
+ * count; the last one resets it and advances generation, which is what the
+ * others poll (with a yield) to leave. Polling rather than blocking in the
+ * kernel keeps the release cheap and the same natively and in gem5's
+ * syscall emulation.
+ */
+class SpinBarrier
+{
+  private:
+    const int threads;
+    std::atomic<int> count;
+    std::atomic<int> generation;
+
+  public:
+    SpinBarrier(int threads): threads(threads), count(0), generation(0) {}
+
+    void wait()
+    {
+        int gen = generation.load();
+        if (count.fetch_add(1) + 1 == threads)
+        {
+            count = 0;
+            generation.fetch_add(1);
+        }
+        else
+        {
+            while (generation.load() == gen)
+                std::this_thread::yield();
+        }
+    }
+};
+
+struct stream_arrays
+{
+    double *a;
+    double *b;
+    double *c;
+};
+
+/*
+ * Stores value to dst[i]. With nt, and if the target has them, bypasses the
+ * caches. The non-temporal version stores two elements at once, so i has to
+ * be even and dst 16 byte aligned.
+ */
+#if HAVE_NT_STORES
+#define STORE2(nt, dst, i, v0, v1) \
+    do { \
+        if (nt) \
+            _mm_stream_pd(&(dst)[i], _mm_set_pd(v1, v0)); \
+        else \
+        { \
+            (dst)[i] = v0; \
+            (dst)[(i) + 1] = v1; \
+        } \
+    } while (0)
+#else
+#define STORE2(nt, dst, i, v0, v1) \
+    do { \
+        (void) (nt); \
+        (dst)[i] = v0; \
+        (dst)[(i) + 1] = v1; \
+    } while (0)
+#endif
+
+/*
+ * Runs kernel over [begin, end). begin is a multiple of BLOCK_ELEMS; end may
+ * not be for the last thread, so the odd element at the end is stored on
+ * its own.
+ */
+template <bool nt>
+static void run_kernel(enum stream_kernel kernel, const stream_arrays &s, size_t begin, size_t end)
+{
+    double *a = s.a;
+    double *b = s.b;
+    double *c = s.c;
+    size_t even_end = begin + (end - begin) / 2 * 2;
+    switch (kernel)
+    {
+      case KERNEL_COPY:
+        for(size_t i=begin; i<even_end; i+=2)
+            STORE2(nt, c, i, a[i], a[i + 1]);
+        if (even_end != end)
+            c[even_end] = a[even_end];
+        break;
+      case KERNEL_SCALE:
+        for(size_t i=begin; i<even_end; i+=2)
+            STORE2(nt, b, i, SCALAR * c[i], SCALAR * c[i + 1]);
+        if (even_end != end)
+            b[even_end] = SCALAR * c[even_end];
+        break;
+      case KERNEL_ADD:
+        for(size_t i=begin; i<even_end; i+=2)
+            STORE2(nt, c, i, a[i] + b[i], a[i + 1] + b[i + 1]);
+        if (even_end != end)
+            c[even_end] = a[even_end] + b[even_end];
+        break;
+      case KERNEL_TRIAD:
+        for(size_t i=begin; i<even_end; i+=2)
+            STORE2(nt, a, i, b[i] + SCALAR * c[i], b[i + 1] + SCALAR * c[i + 1]);
+        if (even_end != end)
+            a[even_end] = b[even_end] + SCALAR * c[even_end];
+        break;
+      default:
+        break;
+    }
+#if HAVE_NT_STORES
+    /* Make the non-temporal stores visible before the barrier. */
+    if (nt)
+        _mm_sfence();
+#endif
+}
+
+static void run_part(enum stream_kernel kernel, const stream_arrays &s, size_t begin,
+                     size_t end, bool nt)
+{
+    if (nt)
+        run_kernel<true>(kernel, s, begin, end);
+    else
+        run_kernel<false>(kernel, s, begin, end);
+}
+
+/*
+ * Checks the arrays against the same kernels run on one element, as STREAM
+ * does. Returns false if any element is off.
+ */
+static bool check(const stream_arrays &s, size_t size, int iterations)
+{
+    double aj = 1.0, bj = 2.0, cj = 0.0;
+    for(int it=0; it<iterations; it++)
+    {
+        cj = aj;
+        bj = SCALAR * cj;
+        cj = aj + bj;
+        aj = bj + SCALAR * cj;
+    }
+    const double epsilon = 1e-13;
+    for(size_t i=0; i<size; i++)
+    {
+        if (std::fabs(s.a[i] - aj) > epsilon * std::fabs(aj) ||
+            std::fabs(s.b[i] - bj) > epsilon * std::fabs(bj) ||
+            std::fabs(s.c[i] - cj) > epsilon * std::fabs(cj))
+        {
+            printf("ERROR: element %zu is (%g, %g, %g), expected (%g, %g, %g)\n",
+                   i, s.a[i], s.b[i], s.c[i], aj, bj, cj);
+            return false;
+        }
+    }
+    return true;
+}
+
+static double *alloc_array(size_t size)
+{
+    size_t bytes = size * sizeof(double);
+    return (double *) aligned_alloc(ALIGNMENT, (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+}
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [--size N] [--threads N] [--iterations N] [--nt-stores]\n", name);
+    printf("Runs copy, scale, add and triad over three arrays of --size doubles\n"
+           "(4194304, 32 MiB each) --iterations (3) times, split over --threads\n"
+           "(1). The first iteration warms up and isn't in the results unless it\n"
+           "is the only one.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = 4 << 20;
+    int threads = 1;
+    int iterations = 3;
+    bool nt = false;
+    static struct option options[] = {
+        {"size", required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 't'},
+        {"iterations", required_argument, NULL, 'i'},
+        {"nt-stores", no_argument, NULL, 'n'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:t:i:h", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+          case 's': size = strtoull(optarg, NULL, 10); break;
+          case 't': threads = atoi(optarg); break;
+          case 'i': iterations = atoi(optarg); break;
+          case 'n': nt = true; break;
+          default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (size < 1 || threads < 1 || iterations < 1)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (nt && !HAVE_NT_STORES)
+        printf("This ISA has no non-temporal stores here, using ordinary stores\n");
+
+    stream_arrays s;
+    s.a = alloc_array(size);
+    s.b = alloc_array(size);
+    s.c = alloc_array(size);
+    if (s.a == NULL || s.b == NULL || s.c == NULL)
+    {
+        printf("Could not allocate three arrays of %zu doubles\n", size);
+        return 1;
+    }
+
+    /* Split the arrays into whole cache blocks, one range for each thread. */
+    std::vector<size_t> bounds(threads + 1);
+    size_t blocks = (size + BLOCK_ELEMS - 1) / BLOCK_ELEMS;
+    for(int t=0; t<=threads; t++)
+        bounds[t] = std::min(size, blocks * t / threads * BLOCK_ELEMS);
+
+    /*
+     * Each thread initializes its own part so that on a NUMA machine the
+     * pages end up next to the thread that uses them.
+     */
+    auto init_part = [&](int t) {
+        for(size_t i=bounds[t]; i<bounds[t + 1]; i++)
+        {
+            s.a[i] = 1.0;
+            s.b[i] = 2.0;
+            s.c[i] = 0.0;
+        }
+    };
+    SpinBarrier barrier(threads);
+    auto worker = [&](int t) {
+        init_part(t);
+        barrier.wait();
+        for(int it=0; it<iterations; it++)
+        {
+            for(int k=0; k<NUM_KERNELS; k++)
+            {
+                barrier.wait();
+                run_part((enum stream_kernel) k, s, bounds[t], bounds[t + 1], nt);
+                barrier.wait();
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for(int t=1; t<threads; t++)
+        workers.emplace_back(worker, t);
+
+    printf("STREAM: %zu doubles per array (%.1f MiB), %d threads, %d iterations%s\n",
+           size, size * sizeof(double) / 1048576.0, threads, iterations,
+           nt ? ", non-temporal stores" : "");
+
+    /* Thread 0 (this one) times the kernels and marks the regions. */
+    std::vector<double> times[NUM_KERNELS];
+    init_part(0);
+    barrier.wait();
+    for(int it=0; it<iterations; it++)
+    {
+        for(int k=0; k<NUM_KERNELS; k++)
+        {
+            auto start = std::chrono::steady_clock::now();
+#ifdef GEM5
+            m5_work_begin(it * NUM_KERNELS + k, 0);
+#endif
+            barrier.wait();
+            run_part((enum stream_kernel) k, s, bounds[0], bounds[1], nt);
+            barrier.wait();
+#ifdef GEM5
+            m5_work_end(it * NUM_KERNELS + k, 0);
+#endif
+            auto end = std::chrono::steady_clock::now();
+            times[k].push_back(std::chrono::duration<double>(end - start).count());
+        }
+    }
+    for(auto &thread: workers)
+        thread.join();
+
+    printf("%-8s %14s %12s %12s %12s\n", "Function", "Best MB/s", "Avg time", "Min time", "Max time");
+    int first = iterations > 1 ? 1 : 0;
+    for(int k=0; k<NUM_KERNELS; k++)
+    {
+        double sum = 0, min = times[k][first], max = times[k][first];
+        for(int it=first; it<iterations; it++)
+        {
+            sum += times[k][it];
+            min = std::min(min, times[k][it]);
+            max = std::max(max, times[k][it]);
+        }
+        double bytes = (double) kernel_arrays[k] * sizeof(double) * size;
+        printf("%-8s %14.1f %12.6f %12.6f %12.6f\n", kernel_names[k],
+               bytes / 1e6 / min, sum / (iterations - first), min, max);
+    }
+
+    bool correct = check(s, size, iterations);
+    printf(correct ? "Solution validates\n" : "Solution does not validate\n");
+
+    free(s.a);
+    free(s.b);
+    free(s.c);
+    return correct ? 0 : 1;
+}
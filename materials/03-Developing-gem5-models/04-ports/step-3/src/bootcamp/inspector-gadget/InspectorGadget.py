@@ -17,6 +17,30 @@ class InspectorGadget(ClockedObject):
     inspection_buffer_entries = Param.Int(
         "Number of entries in the inspection buffer."
     )
+    requestor_quota = Param.Int(
+        0,
+        "Number of inspection buffer entries one requestor can hold before "
+        "it may only take entries that leave this many free for the other "
+        "requestors, 0 for no quota.",
+    )
+    qos_requestor_ids = VectorParam.Int(
+        [], "RequestorIDs to assign a priority class and a weight to."
+    )
+    qos_priorities = VectorParam.Int(
+        [],
+        "Priority class of each requestor in qos_requestor_ids. Higher "
+        "classes are inspected first, other requestors are in class 0.",
+    )
+    qos_weights = VectorParam.Int(
+        [],
+        "Round robin weight of each requestor in qos_requestor_ids within "
+        "its priority class, other requestors have a weight of 1.",
+    )
+    max_requestors = Param.Int(
+        16,
+        "Number of RequestorIDs to keep latency distributions for, larger "
+        "IDs share the last entry.",
+    )
 
     insp_window = Param.Int(
         "Number of entries in front of inspectionBuffer "
@@ -29,6 +53,39 @@ class InspectorGadget(ClockedObject):
 
     output_buffer_entries = Param.Int("Number of entries in output buffer.")
 
+    enable_fast_path = Param.Bool(
+        True,
+        "Whether to inspect requests as soon as they arrive when the gadget "
+        "is idle instead of going through inspectionBuffer.",
+    )
+
+    insp_patterns = VectorParam.String(
+        [], "Byte patterns, as hex strings, to look for in inspected payloads."
+    )
+    insp_forbidden_values = VectorParam.UInt64(
+        [], "64-bit values to look for in inspected payloads."
+    )
+    insp_bloom_filter_bits = Param.Unsigned(
+        4096, "Number of bits in the Bloom filter of forbidden values."
+    )
+    insp_bloom_filter_hashes = Param.Unsigned(
+        3, "Number of hash functions used by the Bloom filter."
+    )
+    insp_bytes_per_cycle = Param.Unsigned(
+        16, "Number of payload bytes an inspection unit scans every cycle."
+    )
+    inspect_responses = Param.Bool(
+        False, "Whether to inspect the payload of read responses too."
+    )
+
+    atomic_sample_weight = Param.Float(
+        0.05,
+        "Weight of the newest request in the running arrival and service "
+        "time estimates used to approximate queuing in atomic mode. "
+        "AtomicSimpleCPU only charges this latency with "
+        "simulate_data_stalls or simulate_inst_stalls.",
+    )
+
     response_buffer_entries = Param.Int(
         "Number of entries in the response buffer."
     )
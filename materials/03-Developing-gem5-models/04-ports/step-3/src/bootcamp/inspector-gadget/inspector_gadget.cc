@@ -1,8 +1,12 @@
 #include "bootcamp/inspector-gadget/inspector_gadget.hh"
 
 #include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <tuple>
 
+#include "base/intmath.hh"
+#include "base/logging.hh"
 #include "debug/InspectorGadget.hh"
 
 namespace gem5
@@ -13,13 +17,16 @@ InspectorGadget::InspectorGadget(const InspectorGadgetParams& params):
     cpuSidePort(this, name() + ".cpu_side_port"),
     memSidePort(this, name() + ".mem_side_port"),
     inspectionBufferEntries(params.inspection_buffer_entries),
+    requestorQuota(params.requestor_quota),
     inspectionBuffer(clockPeriod()),
+    maxRequestors(params.max_requestors),
     inspectionWindow(params.insp_window),
     numInspectionUnits(params.num_insp_units),
     totalInspectionLatency(params.insp_tot_latency),
     inspectionUnitAvailableTimes((size_t) params.num_insp_units, 0),
     outputBufferEntries(params.output_buffer_entries),
     outputBuffer(clockPeriod()),
+    fastPathEnabled(params.enable_fast_path),
     responseBufferEntries(params.response_buffer_entries),
     responseBuffer(clockPeriod()),
     nextInspectionEvent([this]() { processNextInspectionEvent(); }, name() + ".nextInspectionEvent"),
@@ -27,9 +34,46 @@ InspectorGadget::InspectorGadget(const InspectorGadgetParams& params):
     nextReqRetryEvent([this](){ processNextReqRetryEvent(); }, name() + ".nextReqRetryEvent"),
     nextRespSendEvent([this](){ processNextRespSendEvent(); }, name() + ".nextRespSendEvent"),
     nextRespRetryEvent([this](){ processNextRespRetryEvent(); }, name() + ".nextRespRetryEvent"),
+    payloadScanner(params.insp_bloom_filter_bits, params.insp_bloom_filter_hashes),
+    inspectionBytesPerCycle(params.insp_bytes_per_cycle),
+    inspectResponses(params.inspect_responses),
     nextAvailableSeqNum(0), nextExpectedSeqNum(0),
+    numPendingResponses(0),
+    atomicSampleWeight(params.atomic_sample_weight),
+    avgAtomicInterArrival(0), avgAtomicServiceTime(0),
+    lastAtomicArrival(MaxTick), numAtomicArrivals(0),
     stats(this)
-{}
+{
+    fatal_if(inspectionBytesPerCycle <= 0, "insp_bytes_per_cycle should be positive!");
+    fatal_if(params.insp_bloom_filter_bits == 0, "insp_bloom_filter_bits should be positive!");
+    fatal_if(params.insp_bloom_filter_hashes == 0, "insp_bloom_filter_hashes should be positive!");
+    fatal_if(atomicSampleWeight <= 0 || atomicSampleWeight > 1,
+            "atomic_sample_weight should be in (0, 1]!");
+    fatal_if(maxRequestors <= 0, "max_requestors should be positive!");
+    fatal_if(params.qos_priorities.size() != params.qos_requestor_ids.size() ||
+            params.qos_weights.size() != params.qos_requestor_ids.size(),
+            "qos_priorities and qos_weights should have one entry for "
+            "every requestor in qos_requestor_ids!");
+    for (size_t i = 0; i < params.qos_requestor_ids.size(); i++) {
+        fatal_if(params.qos_weights[i] <= 0, "QoS weights should be positive!");
+        inspectionBuffer.setQoSClass(params.qos_requestor_ids[i],
+                                    params.qos_priorities[i],
+                                    params.qos_weights[i]);
+    }
+    for (const auto& pattern: params.insp_patterns) {
+        fatal_if(pattern.empty() || pattern.size() % 2 != 0 ||
+                !std::all_of(pattern.begin(), pattern.end(), ::isxdigit),
+                "Pattern %s is not a valid hex string!", pattern);
+        std::vector<uint8_t> bytes;
+        for (size_t i = 0; i < pattern.size(); i += 2) {
+            bytes.push_back(std::stoul(pattern.substr(i, 2), nullptr, 16));
+        }
+        payloadScanner.addPattern(bytes);
+    }
+    for (const auto& value: params.insp_forbidden_values) {
+        payloadScanner.addForbiddenValue(value);
+    }
+}
 
 void
 InspectorGadget::init()
@@ -49,19 +93,213 @@ InspectorGadget::getPort(const std::string &if_name, PortID idx)
     }
 }
 
+bool
+InspectorGadget::isDrained() const
+{
+    return inspectionBuffer.empty() && outputBuffer.empty() && responseBuffer.empty() &&
+        numPendingResponses == 0 &&
+        !cpuSidePort.needRetry() && !cpuSidePort.blocked() &&
+        !memSidePort.needRetry() && !memSidePort.blocked();
+}
+
+void
+InspectorGadget::tryFinishDrain()
+{
+    if (drainState() == DrainState::Draining && isDrained()) {
+        DPRINTF(InspectorGadget, "%s: Done draining.\n", __func__);
+        signalDrainDone();
+    }
+}
+
+DrainState
+InspectorGadget::drain()
+{
+    if (isDrained()) {
+        return DrainState::Drained;
+    }
+    DPRINTF(InspectorGadget, "%s: Draining %d inspection, %d output, %d response entries "
+            "and %d pending responses.\n", __func__, inspectionBuffer.size(),
+            outputBuffer.size(), responseBuffer.size(), numPendingResponses);
+    return DrainState::Draining;
+}
+
+void
+InspectorGadget::serialize(CheckpointOut& cp) const
+{
+    SERIALIZE_SCALAR(nextAvailableSeqNum);
+    SERIALIZE_SCALAR(nextExpectedSeqNum);
+    SERIALIZE_SCALAR(avgAtomicInterArrival);
+    SERIALIZE_SCALAR(avgAtomicServiceTime);
+    SERIALIZE_SCALAR(lastAtomicArrival);
+    SERIALIZE_SCALAR(numAtomicArrivals);
+}
+
+void
+InspectorGadget::unserialize(CheckpointIn& cp)
+{
+    UNSERIALIZE_SCALAR(nextAvailableSeqNum);
+    UNSERIALIZE_SCALAR(nextExpectedSeqNum);
+    UNSERIALIZE_SCALAR(avgAtomicInterArrival);
+    UNSERIALIZE_SCALAR(avgAtomicServiceTime);
+    UNSERIALIZE_SCALAR(lastAtomicArrival);
+    UNSERIALIZE_SCALAR(numAtomicArrivals);
+}
+
 Tick
 InspectorGadget::align(Tick when)
 {
     return clockEdge((Cycles) std::ceil((when - curTick()) / clockPeriod()));
 }
 
+int
+InspectorGadget::requestorStatIndex(RequestorID requestor_id) const
+{
+    return std::min<int>(requestor_id, maxRequestors - 1);
+}
+
+InspectorGadget::InspectionBuffer::RequestorQueue&
+InspectorGadget::InspectionBuffer::getQueue(RequestorID requestor_id)
+{
+    auto it = queues.find(requestor_id);
+    if (it == queues.end()) {
+        int priority = 0;
+        int weight = 1;
+        auto qos_class = qosClasses.find(requestor_id);
+        if (qos_class != qosClasses.end()) {
+            std::tie(priority, weight) = qos_class->second;
+        }
+        it = queues.emplace(requestor_id, RequestorQueue(latency, priority, weight)).first;
+    }
+    return it->second;
+}
+
+void
+InspectorGadget::InspectionBuffer::setQoSClass(RequestorID requestor_id, int priority, int weight)
+{
+    panic_if(queues.count(requestor_id) != 0, "Should set QoS classes before receiving requests!");
+    qosClasses[requestor_id] = std::make_pair(priority, weight);
+}
+
 void
-InspectorGadget::inspectRequest(PacketPtr pkt)
+InspectorGadget::InspectionBuffer::push(PacketPtr pkt, Tick insertion_time)
+{
+    getQueue(pkt->requestorId()).items.push(pkt, insertion_time);
+    numItems++;
+}
+
+InspectorGadget::InspectionBuffer::RequestorQueue*
+InspectorGadget::InspectionBuffer::arbitrate(Tick current_time)
+{
+    bool have_ready = false;
+    int top_priority = 0;
+    for (auto& [requestor_id, queue]: queues) {
+        if (queue.items.hasReady(current_time) &&
+            (!have_ready || queue.priority > top_priority)) {
+            have_ready = true;
+            top_priority = queue.priority;
+        }
+    }
+    if (!have_ready) {
+        return nullptr;
+    }
+
+    // Go around once starting after the last granted requestor. If every
+    // ready requestor in the top class is out of credits, refill the credits
+    // of the whole class and go around again.
+    for (int round = 0; round < 2; round++) {
+        auto it = queues.upper_bound(lastGrantedRequestor);
+        for (size_t i = 0; i < queues.size(); i++, it++) {
+            if (it == queues.end()) {
+                it = queues.begin();
+            }
+            RequestorQueue& queue = it->second;
+            if (queue.priority == top_priority && queue.credits > 0 &&
+                queue.items.hasReady(current_time)) {
+                queue.credits--;
+                lastGrantedRequestor = it->first;
+                return &queue;
+            }
+        }
+        for (auto& [requestor_id, queue]: queues) {
+            if (queue.priority == top_priority) {
+                queue.credits = queue.weight;
+            }
+        }
+    }
+    panic("Should always find a requestor after refilling credits!");
+}
+
+std::pair<PacketPtr, Tick>
+InspectorGadget::InspectionBuffer::pop(Tick current_time)
+{
+    RequestorQueue* queue = arbitrate(current_time);
+    panic_if(queue == nullptr, "Should never try to pop if no ready packets!");
+    std::pair<PacketPtr, Tick> entry(queue->items.front(), queue->items.frontTime());
+    queue->items.pop();
+    numItems--;
+    return entry;
+}
+
+size_t
+InspectorGadget::InspectionBuffer::size(RequestorID requestor_id) const
+{
+    auto it = queues.find(requestor_id);
+    return it == queues.end() ? 0 : it->second.items.size();
+}
+
+bool
+InspectorGadget::InspectionBuffer::hasReady(Tick current_time) const
+{
+    for (const auto& [requestor_id, queue]: queues) {
+        if (queue.items.hasReady(current_time)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Tick
+InspectorGadget::InspectionBuffer::firstReadyTime()
+{
+    Tick first_ready_time = MaxTick;
+    for (auto& [requestor_id, queue]: queues) {
+        if (!queue.items.empty()) {
+            first_ready_time = std::min(first_ready_time, queue.items.firstReadyTime());
+        }
+    }
+    return first_ready_time;
+}
+
+Cycles
+InspectorGadget::inspectPayload(PacketPtr pkt)
+{
+    if (payloadScanner.empty() || !pkt->hasData()) {
+        return Cycles(0);
+    }
+
+    unsigned size = pkt->getSize();
+    stats.numPayloadsInspected++;
+    stats.numBytesInspected += size;
+    if (payloadScanner.scan(pkt->getConstPtr<uint8_t>(), size)) {
+        DPRINTF(InspectorGadget, "%s: Found a match in pkt: %s.\n", __func__, pkt->print());
+        stats.numPayloadMatches++;
+    } else {
+        stats.numPayloadMisses++;
+    }
+    return Cycles(divCeil(size, inspectionBytesPerCycle));
+}
+
+Cycles
+InspectorGadget::inspectRequest(PacketPtr pkt, Tick entry_time)
 {
     panic_if(!pkt->isRequest(), "Should only inspect requests!");
-    SequenceNumberTag* seq_num_tag = new SequenceNumberTag(nextAvailableSeqNum);
+    SequenceNumberTag* seq_num_tag = new SequenceNumberTag(nextAvailableSeqNum, entry_time);
     pkt->pushSenderState(seq_num_tag);
     nextAvailableSeqNum++;
+    if (pkt->isWrite()) {
+        return totalInspectionLatency + inspectPayload(pkt);
+    }
+    return totalInspectionLatency;
 }
 
 void
@@ -73,6 +311,8 @@ InspectorGadget::inspectResponse(PacketPtr pkt)
     if (seq_num_tag->sequenceNumber != nextExpectedSeqNum) {
         stats.numReqRespDisplacements++;
     }
+    stats.requestorTotalLatency[requestorStatIndex(pkt->requestorId())].sample(
+        ticksToCycles(curTick() - seq_num_tag->entryTime));
     delete pkt->popSenderState();
     nextExpectedSeqNum++;
 }
@@ -103,14 +343,65 @@ InspectorGadget::CPUSidePort::recvTimingReq(PacketPtr pkt)
 bool
 InspectorGadget::recvTimingReq(PacketPtr pkt)
 {
+    if (tryFastPath(pkt)) {
+        return true;
+    }
     if (inspectionBuffer.size() >= inspectionBufferEntries) {
         return false;
     }
+    // Every requestor shares cpuSidePort, so refusing one request stalls all
+    // of them behind it until the retry. Let a requestor over its quota keep
+    // taking entries as long as requestorQuota entries stay free for the
+    // others and only refuse it after that.
+    int free_entries = inspectionBufferEntries - (int) inspectionBuffer.size();
+    if (requestorQuota > 0 && inspectionBuffer.size(pkt->requestorId()) >= requestorQuota &&
+        free_entries <= requestorQuota) {
+        DPRINTF(InspectorGadget, "%s: Requestor %d is over its quota.\n", __func__, pkt->requestorId());
+        stats.numQuotaRejections++;
+        return false;
+    }
     inspectionBuffer.push(pkt, curTick());
     scheduleNextInspectionEvent(nextCycle());
     return true;
 }
 
+bool
+InspectorGadget::tryFastPath(PacketPtr pkt)
+{
+    if (!fastPathEnabled || !inspectionBuffer.empty() || !outputBuffer.empty() ||
+        memSidePort.blocked() || nextInspectionEvent.scheduled()) {
+        return false;
+    }
+
+    // Inspect the packet now, but account for it as if it was inspected at
+    // the time processNextInspectionEvent would have picked it up from
+    // inspectionBuffer. That way only nextReqSendEvent is scheduled for it.
+    Tick first_avail_insp_unit_time = \
+        *std::min_element(
+                        inspectionUnitAvailableTimes.begin(),
+                        inspectionUnitAvailableTimes.end()
+                        );
+    Tick insp_time = align(std::max({nextCycle(),
+                                    curTick() + clockPeriod(),
+                                    first_avail_insp_unit_time
+                                    }));
+    int unit = 0;
+    while (inspectionUnitAvailableTimes[unit] > insp_time) {
+        unit++;
+    }
+
+    DPRINTF(InspectorGadget, "%s: Taking fast path for pkt: %s.\n", __func__, pkt->print());
+    stats.numFastPathRequests++;
+    stats.totalInspectionBufferLatency += insp_time - curTick();
+    stats.requestorInspectionBufferLatency[requestorStatIndex(pkt->requestorId())].sample(
+        ticksToCycles(insp_time - curTick()));
+    Tick insp_done_time = insp_time + cyclesToTicks(inspectRequest(pkt, curTick()));
+    inspectionUnitAvailableTimes[unit] = insp_done_time;
+    outputBuffer.push(pkt, insp_done_time);
+    scheduleNextReqSendEvent(nextCycle());
+    return true;
+}
+
 Tick
 InspectorGadget::CPUSidePort::recvAtomic(PacketPtr pkt)
 {
@@ -121,7 +412,62 @@ InspectorGadget::CPUSidePort::recvAtomic(PacketPtr pkt)
 Tick
 InspectorGadget::recvAtomic(PacketPtr pkt)
 {
-    return clockPeriod() + memSidePort.sendAtomic(pkt);
+    Cycles insp_latency = totalInspectionLatency;
+    if (pkt->isWrite()) {
+        insp_latency = insp_latency + inspectPayload(pkt);
+    }
+    Tick service_time = cyclesToTicks(insp_latency);
+    Tick queue_latency = atomicQueueLatency(service_time);
+
+    stats.numAtomicRequests++;
+    stats.totalAtomicInspectionLatency += service_time;
+    stats.totalAtomicQueueLatency += queue_latency;
+
+    // One cycle in each of inspectionBuffer, outputBuffer and responseBuffer
+    // like in timing mode.
+    Tick latency = cyclesToTicks(Cycles(3)) + queue_latency + service_time;
+    latency += memSidePort.sendAtomic(pkt);
+    if (inspectResponses && pkt->isRead()) {
+        latency += cyclesToTicks(inspectPayload(pkt));
+    }
+    return latency;
+}
+
+Tick
+InspectorGadget::atomicQueueLatency(Tick service_time)
+{
+    Tick now = curTick();
+    numAtomicArrivals++;
+    if (numAtomicArrivals == 1) {
+        avgAtomicServiceTime = service_time;
+        lastAtomicArrival = now;
+        return 0;
+    }
+    // Atomic accesses in the same tick (e.g. a burst from one instruction)
+    // would pull the estimate to 0 and charge max_latency for every burst,
+    // so count them as at least a cycle apart.
+    double inter_arrival = std::max(now - lastAtomicArrival, clockPeriod());
+    if (numAtomicArrivals == 2) {
+        // Seed the estimate with the first measurement rather than let it
+        // climb up from 0, which would charge max_latency until it got there.
+        avgAtomicInterArrival = inter_arrival;
+    } else {
+        avgAtomicInterArrival += atomicSampleWeight * (inter_arrival - avgAtomicInterArrival);
+    }
+    avgAtomicServiceTime += atomicSampleWeight * (service_time - avgAtomicServiceTime);
+    lastAtomicArrival = now;
+
+    // A full inspectionBuffer bounds how long a request could wait.
+    Tick max_latency = service_time * divCeil(inspectionBufferEntries, numInspectionUnits);
+    double capacity = numInspectionUnits * avgAtomicInterArrival;
+    if (avgAtomicServiceTime >= capacity) {
+        return max_latency;
+    }
+    // Treat the inspection units as one unit numInspectionUnits times as fast
+    // and use the mean waiting time of an M/D/1 queue.
+    double utilization = avgAtomicServiceTime / capacity;
+    double wait = (avgAtomicServiceTime / numInspectionUnits) * utilization / (2 * (1 - utilization));
+    return std::min(max_latency, (Tick) wait);
 }
 
 void
@@ -150,6 +496,15 @@ InspectorGadget::CPUSidePort::sendPacket(PacketPtr pkt)
     }
 }
 
+void
+InspectorGadget::CPUSidePort::trySendRetry()
+{
+    // Clear the flag first since the retry may call recvTimingReq right away.
+    needToSendRetry = false;
+    DPRINTF(InspectorGadget, "%s: Sending retry signal.\n", __func__);
+    sendRetryReq();
+}
+
 // Too-Much-Code
 void
 InspectorGadget::CPUSidePort::recvRespRetry()
@@ -171,6 +526,7 @@ void
 InspectorGadget::recvRespRetry()
 {
     scheduleNextRespSendEvent(nextCycle());
+    tryFinishDrain();
 }
 
 void
@@ -204,11 +560,24 @@ InspectorGadget::recvTimingResp(PacketPtr pkt)
     if (responseBuffer.size() >= responseBufferEntries) {
         return false;
     }
-    responseBuffer.push(pkt, curTick());
+    Cycles scan_latency = Cycles(0);
+    if (inspectResponses && pkt->isRead()) {
+        scan_latency = inspectPayload(pkt);
+    }
+    responseBuffer.push(pkt, curTick() + cyclesToTicks(scan_latency));
     scheduleNextRespSendEvent(nextCycle());
     return true;
 }
 
+// Too-Much-Code
+void
+InspectorGadget::MemSidePort::trySendRetry()
+{
+    needToSendRetry = false;
+    DPRINTF(InspectorGadget, "%s: Sending retry signal.\n", __func__);
+    sendRetryResp();
+}
+
 void
 InspectorGadget::MemSidePort::recvReqRetry()
 {
@@ -228,6 +597,7 @@ void
 InspectorGadget::recvReqRetry()
 {
     scheduleNextReqSendEvent(nextCycle());
+    tryFinishDrain();
 }
 
 void
@@ -241,20 +611,21 @@ InspectorGadget::processNextInspectionEvent()
             DPRINTF(InspectorGadget, "%s: Inspection unit %d is busy.\n", __func__,  i);
             continue;
         }
-        if (inspectionBuffer.empty()) {
-            DPRINTF(InspectorGadget, "%s: Inspection buffer is empty.\n", __func__);
+        if (!inspectionBuffer.hasReady(curTick())) {
+            DPRINTF(InspectorGadget, "%s: No ready packets in inspection buffer.\n", __func__);
             break;
         }
         if (outputBuffer.size() >= outputBufferEntries) {
             DPRINTF(InspectorGadget, "%s: Output buffer is full.\n", __func__);
             break;
         }
-        stats.totalInspectionBufferLatency += curTick() - inspectionBuffer.frontTime();
-        PacketPtr pkt = inspectionBuffer.front();
-        inspectRequest(pkt);
-        outputBuffer.push(pkt, clockEdge(totalInspectionLatency));
-        inspectionBuffer.pop();
-        inspectionUnitAvailableTimes[i] = clockEdge(totalInspectionLatency);
+        auto [pkt, entry_time] = inspectionBuffer.pop(curTick());
+        stats.totalInspectionBufferLatency += curTick() - entry_time;
+        stats.requestorInspectionBufferLatency[requestorStatIndex(pkt->requestorId())].sample(
+            ticksToCycles(curTick() - entry_time));
+        Cycles insp_latency = inspectRequest(pkt, entry_time);
+        outputBuffer.push(pkt, clockEdge(insp_latency));
+        inspectionUnitAvailableTimes[i] = clockEdge(insp_latency);
         insp_window_left--;
         if (insp_window_left == 0) {
             break;
@@ -298,11 +669,15 @@ InspectorGadget::processNextReqSendEvent()
 
     stats.numRequestsFwded++;
     PacketPtr pkt = outputBuffer.front();
+    if (pkt->needsResponse()) {
+        numPendingResponses++;
+    }
     memSidePort.sendPacket(pkt);
     outputBuffer.pop();
 
     scheduleNextInspectionEvent(nextCycle());
     scheduleNextReqSendEvent(nextCycle());
+    tryFinishDrain();
 }
 
 void
@@ -321,7 +696,8 @@ void
 InspectorGadget::processNextReqRetryEvent()
 {
     panic_if(!cpuSidePort.needRetry(), "Should never try to send retry if not needed!");
-    cpuSidePort.sendRetryReq();
+    cpuSidePort.trySendRetry();
+    tryFinishDrain();
 }
 
 void
@@ -346,9 +722,11 @@ InspectorGadget::processNextRespSendEvent()
     inspectResponse(pkt);
     cpuSidePort.sendPacket(pkt);
     responseBuffer.pop();
+    numPendingResponses--;
 
     scheduleNextRespRetryEvent(nextCycle());
     scheduleNextRespSendEvent(nextCycle());
+    tryFinishDrain();
 }
 
 // Too-Much-Code
@@ -369,7 +747,8 @@ void
 InspectorGadget::processNextRespRetryEvent()
 {
     panic_if(!memSidePort.needRetry(), "Should never try to send retry if not needed!");
-    memSidePort.sendRetryResp();
+    memSidePort.trySendRetry();
+    tryFinishDrain();
 }
 
 // Too-Much-Code
@@ -387,8 +766,22 @@ InspectorGadget::InspectorGadgetStats::InspectorGadgetStats(InspectorGadget* ins
     ADD_STAT(numRequestsFwded, statistics::units::Count::get(), "Number of requests forwarded."),
     ADD_STAT(totalResponseBufferLatency, statistics::units::Tick::get(), "Total response buffer latency."),
     ADD_STAT(numResponsesFwded, statistics::units::Count::get(), "Number of responses forwarded."),
-    ADD_STAT(numReqRespDisplacements, statistics::units::Count::get(), "Number of request-response displacements.")
-{}
+    ADD_STAT(numReqRespDisplacements, statistics::units::Count::get(), "Number of request-response displacements."),
+    ADD_STAT(numPayloadsInspected, statistics::units::Count::get(), "Number of payloads inspected."),
+    ADD_STAT(numBytesInspected, statistics::units::Byte::get(), "Number of payload bytes inspected."),
+    ADD_STAT(numPayloadMatches, statistics::units::Count::get(), "Number of inspected payloads that matched a pattern or forbidden value."),
+    ADD_STAT(numPayloadMisses, statistics::units::Count::get(), "Number of inspected payloads that matched nothing."),
+    ADD_STAT(numAtomicRequests, statistics::units::Count::get(), "Number of requests received in atomic mode."),
+    ADD_STAT(totalAtomicInspectionLatency, statistics::units::Tick::get(), "Total inspection latency charged in atomic mode."),
+    ADD_STAT(totalAtomicQueueLatency, statistics::units::Tick::get(), "Total estimated queuing latency charged in atomic mode."),
+    ADD_STAT(numQuotaRejections, statistics::units::Count::get(), "Number of requests rejected for exceeding the requestor quota."),
+    ADD_STAT(numFastPathRequests, statistics::units::Count::get(), "Number of requests that bypassed the inspection buffer."),
+    ADD_STAT(requestorInspectionBufferLatency, statistics::units::Cycle::get(), "Distribution of inspection buffer latency per requestor."),
+    ADD_STAT(requestorTotalLatency, statistics::units::Cycle::get(), "Distribution of latency from arrival to response per requestor.")
+{
+    requestorInspectionBufferLatency.init(inspector_gadget->maxRequestors, 0, 255, 8);
+    requestorTotalLatency.init(inspector_gadget->maxRequestors, 0, 1023, 32);
+}
 
 } // namespace gem5
 
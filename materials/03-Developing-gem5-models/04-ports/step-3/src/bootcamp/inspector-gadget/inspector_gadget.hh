@@ -1,16 +1,22 @@
 #ifndef __BOOTCAMP_INSPECTOR_GADGET_INSPECTOR_GADGET_HH__
 #define __BOOTCAMP_INSPECTOR_GADGET_INSPECTOR_GADGET_HH__
 
+#include <map>
 #include <queue>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "base/stats/group.hh"
 #include "base/statistics.hh"
+#include "bootcamp/inspector-gadget/payload_scanner.hh"
 #include "mem/packet.hh"
 #include "mem/port.hh"
 #include "params/InspectorGadget.hh"
 #include "sim/clocked_object.hh"
+#include "sim/drain.hh"
 #include "sim/eventq.hh"
+#include "sim/serialize.hh"
 
 namespace gem5
 {
@@ -32,6 +38,7 @@ class InspectorGadget : public ClockedObject
         bool needRetry() const { return needToSendRetry; }
         bool blocked() const { return blockedPacket != nullptr; }
         void sendPacket(PacketPtr pkt);
+        void trySendRetry();
 
         virtual AddrRangeList getAddrRanges() const override;
         virtual bool recvTimingReq(PacketPtr pkt) override;
@@ -54,6 +61,7 @@ class InspectorGadget : public ClockedObject
         bool needRetry() const { return needToSendRetry; }
         bool blocked() const { return blockedPacket != nullptr; }
         void sendPacket(PacketPtr pkt);
+        void trySendRetry();
 
         virtual bool recvTimingResp(PacketPtr pkt) override;
         virtual void recvReqRetry() override;
@@ -93,11 +101,56 @@ class InspectorGadget : public ClockedObject
         Tick firstReadyTime() { return insertionTimes.front() + latency; }
     };
 
+    // Holds one TimedQueue per requestor and picks the next packet to
+    // inspect with strict priority between priority classes and weighted
+    // round robin between the requestors of the same class.
+    class InspectionBuffer
+    {
+      private:
+        struct RequestorQueue
+        {
+            TimedQueue<PacketPtr> items;
+            int priority;
+            int weight;
+            int credits;
+            RequestorQueue(Tick latency, int priority, int weight):
+                items(latency), priority(priority), weight(weight), credits(weight)
+            {}
+        };
+
+        Tick latency;
+        std::map<RequestorID, RequestorQueue> queues;
+        std::unordered_map<RequestorID, std::pair<int, int>> qosClasses;
+        RequestorID lastGrantedRequestor;
+        size_t numItems;
+
+        RequestorQueue& getQueue(RequestorID requestor_id);
+        RequestorQueue* arbitrate(Tick current_time);
+
+      public:
+        InspectionBuffer(Tick latency):
+            latency(latency), lastGrantedRequestor(0), numItems(0)
+        {}
+
+        void setQoSClass(RequestorID requestor_id, int priority, int weight);
+        void push(PacketPtr pkt, Tick insertion_time);
+        // Removes the packet chosen by the arbiter among the ones ready at
+        // current_time and returns it with its insertion time.
+        std::pair<PacketPtr, Tick> pop(Tick current_time);
+
+        bool empty() const { return numItems == 0; }
+        size_t size() const { return numItems; }
+        size_t size(RequestorID requestor_id) const;
+        bool hasReady(Tick current_time) const;
+        Tick firstReadyTime();
+    };
+
     struct SequenceNumberTag: public Packet::SenderState
     {
         uint64_t sequenceNumber;
-        SequenceNumberTag(uint64_t sequenceNumber):
-            SenderState(), sequenceNumber(sequenceNumber)
+        Tick entryTime;
+        SequenceNumberTag(uint64_t sequenceNumber, Tick entryTime):
+            SenderState(), sequenceNumber(sequenceNumber), entryTime(entryTime)
         {}
     };
 
@@ -108,6 +161,17 @@ class InspectorGadget : public ClockedObject
         statistics::Scalar totalResponseBufferLatency;
         statistics::Scalar numResponsesFwded;
         statistics::Scalar numReqRespDisplacements;
+        statistics::Scalar numPayloadsInspected;
+        statistics::Scalar numBytesInspected;
+        statistics::Scalar numPayloadMatches;
+        statistics::Scalar numPayloadMisses;
+        statistics::Scalar numAtomicRequests;
+        statistics::Scalar totalAtomicInspectionLatency;
+        statistics::Scalar totalAtomicQueueLatency;
+        statistics::Scalar numQuotaRejections;
+        statistics::Scalar numFastPathRequests;
+        statistics::VectorDistribution requestorInspectionBufferLatency;
+        statistics::VectorDistribution requestorTotalLatency;
         InspectorGadgetStats(InspectorGadget* inspector_gadget);
     };
 
@@ -117,7 +181,10 @@ class InspectorGadget : public ClockedObject
     MemSidePort memSidePort;
 
     int inspectionBufferEntries;
-    TimedQueue<PacketPtr> inspectionBuffer;
+    int requestorQuota;
+    InspectionBuffer inspectionBuffer;
+    int maxRequestors;
+    int requestorStatIndex(RequestorID requestor_id) const;
 
     int inspectionWindow;
     int numInspectionUnits;
@@ -127,6 +194,9 @@ class InspectorGadget : public ClockedObject
     int outputBufferEntries;
     TimedQueue<PacketPtr> outputBuffer;
 
+    bool fastPathEnabled;
+    bool tryFastPath(PacketPtr pkt);
+
     int responseBufferEntries;
     TimedQueue<PacketPtr> responseBuffer;
 
@@ -150,12 +220,33 @@ class InspectorGadget : public ClockedObject
     void processNextRespRetryEvent();
     void scheduleNextRespRetryEvent(Tick when);
 
+    PayloadScanner payloadScanner;
+    int inspectionBytesPerCycle;
+    bool inspectResponses;
+    Cycles inspectPayload(PacketPtr pkt);
+
     uint64_t nextAvailableSeqNum;
-    void inspectRequest(PacketPtr pkt);
+    Cycles inspectRequest(PacketPtr pkt, Tick entry_time);
 
     uint64_t nextExpectedSeqNum;
     void inspectResponse(PacketPtr pkt);
 
+    // Number of requests forwarded to memory that still need a response.
+    int numPendingResponses;
+    bool isDrained() const;
+    void tryFinishDrain();
+
+    // Running estimates of request inter-arrival and inspection times in
+    // atomic mode, used to approximate the queuing in inspectionBuffer. Note
+    // that AtomicSimpleCPU only adds the latency a request returns to its
+    // time with simulate_data_stalls (or simulate_inst_stalls) set.
+    double atomicSampleWeight;
+    double avgAtomicInterArrival;
+    double avgAtomicServiceTime;
+    Tick lastAtomicArrival;
+    uint64_t numAtomicArrivals;
+    Tick atomicQueueLatency(Tick service_time);
+
     Tick align(Tick when);
 
     InspectorGadgetStats stats;
@@ -166,6 +257,10 @@ class InspectorGadget : public ClockedObject
     virtual void init() override;
     virtual Port& getPort(const std::string& if_name, PortID idx=InvalidPortID) override;
 
+    virtual DrainState drain() override;
+    virtual void serialize(CheckpointOut& cp) const override;
+    virtual void unserialize(CheckpointIn& cp) override;
+
     AddrRangeList getAddrRanges() const;
     bool recvTimingReq(PacketPtr pkt);
     Tick recvAtomic(PacketPtr pkt);
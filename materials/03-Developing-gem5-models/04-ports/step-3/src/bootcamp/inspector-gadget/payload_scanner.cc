@@ -0,0 +1,152 @@
+#include "bootcamp/inspector-gadget/payload_scanner.hh"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace gem5
+{
+
+namespace
+{
+
+uint64_t
+mix(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+} // anonymous namespace
+
+PayloadScanner::PayloadScanner(size_t bloom_filter_bits, unsigned bloom_filter_hashes):
+    bloomFilter((bloom_filter_bits + 63) / 64, 0),
+    bloomFilterBits(bloomFilter.size() * 64),
+    bloomFilterHashes(bloom_filter_hashes),
+    haveForbiddenValues(false)
+{}
+
+void
+PayloadScanner::addPattern(const std::vector<uint8_t>& pattern)
+{
+    if (!pattern.empty()) {
+        patterns.push_back(pattern);
+    }
+}
+
+void
+PayloadScanner::addForbiddenValue(uint64_t value)
+{
+    uint64_t h1 = mix(value);
+    uint64_t h2 = mix(h1) | 1;
+    for (unsigned i = 0; i < bloomFilterHashes; i++) {
+        uint64_t bit = (h1 + i * h2) % bloomFilterBits;
+        bloomFilter[bit / 64] |= (1ULL << (bit % 64));
+    }
+    haveForbiddenValues = true;
+}
+
+bool
+PayloadScanner::bloomFilterContains(uint64_t value) const
+{
+    uint64_t h1 = mix(value);
+    uint64_t h2 = mix(h1) | 1;
+    for (unsigned i = 0; i < bloomFilterHashes; i++) {
+        uint64_t bit = (h1 + i * h2) % bloomFilterBits;
+        if ((bloomFilter[bit / 64] & (1ULL << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+PayloadScanner::findPattern(const uint8_t* data, size_t size,
+                            const std::vector<uint8_t>& pattern) const
+{
+    const size_t length = pattern.size();
+    if (length > size) {
+        return false;
+    }
+
+    // Compare the first and last byte of the pattern against a whole vector
+    // of candidate positions at once and only fall back to memcmp for the
+    // positions where both agree.
+    size_t pos = 0;
+#if defined(__AVX2__)
+    const __m256i first = _mm256_set1_epi8(pattern.front());
+    const __m256i last = _mm256_set1_epi8(pattern.back());
+    for (; pos + length - 1 + 32 <= size; pos += 32) {
+        __m256i block_first = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(data + pos));
+        __m256i block_last = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(data + pos + length - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first, block_first),
+            _mm256_cmpeq_epi8(last, block_last)));
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (std::memcmp(data + pos + bit, pattern.data(), length) == 0) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(pattern.front());
+    const __m128i last = _mm_set1_epi8(pattern.back());
+    for (; pos + length - 1 + 16 <= size; pos += 16) {
+        __m128i block_first = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + pos));
+        __m128i block_last = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + pos + length - 1));
+        uint32_t mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first, block_first),
+            _mm_cmpeq_epi8(last, block_last)));
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (std::memcmp(data + pos + bit, pattern.data(), length) == 0) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; pos + length <= size; pos++) {
+        if (data[pos] == pattern.front() &&
+            std::memcmp(data + pos, pattern.data(), length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+PayloadScanner::scan(const uint8_t* data, size_t size) const
+{
+    for (const auto& pattern: patterns) {
+        if (findPattern(data, size, pattern)) {
+            return true;
+        }
+    }
+    if (haveForbiddenValues) {
+        for (size_t pos = 0; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)) {
+            uint64_t value;
+            std::memcpy(&value, data + pos, sizeof(uint64_t));
+            if (bloomFilterContains(value)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace gem5
@@ -0,0 +1,42 @@
+#ifndef __BOOTCAMP_INSPECTOR_GADGET_PAYLOAD_SCANNER_HH__
+#define __BOOTCAMP_INSPECTOR_GADGET_PAYLOAD_SCANNER_HH__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gem5
+{
+
+// Host-side kernels to look for byte patterns and forbidden values in packet
+// payloads. Pattern search uses AVX2 or SSE2 when the host supports it and
+// falls back to a scalar loop otherwise.
+class PayloadScanner
+{
+  private:
+    std::vector<std::vector<uint8_t>> patterns;
+
+    // Bloom filter of forbidden 64-bit values, checked against every
+    // aligned 8-byte word of the payload.
+    std::vector<uint64_t> bloomFilter;
+    size_t bloomFilterBits;
+    unsigned bloomFilterHashes;
+    bool haveForbiddenValues;
+
+    bool findPattern(const uint8_t* data, size_t size,
+                     const std::vector<uint8_t>& pattern) const;
+    bool bloomFilterContains(uint64_t value) const;
+
+  public:
+    PayloadScanner(size_t bloom_filter_bits, unsigned bloom_filter_hashes);
+
+    void addPattern(const std::vector<uint8_t>& pattern);
+    void addForbiddenValue(uint64_t value);
+
+    bool empty() const { return patterns.empty() && !haveForbiddenValues; }
+    bool scan(const uint8_t* data, size_t size) const;
+};
+
+} // namespace gem5
+
+#endif // __BOOTCAMP_INSPECTOR_GADGET_PAYLOAD_SCANNER_HH__
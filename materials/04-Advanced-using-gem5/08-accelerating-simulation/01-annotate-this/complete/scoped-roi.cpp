@@ -0,0 +1,45 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Regions that pick the right m5ops on their own and vanish in native
+// builds. See ../scoped_roi.h.
+#include "../scoped_roi.h"
+
+// Sums rows of a matrix, the whole sum as one region and every row as a
+// region nested in it. Run it with a handler that counts markers per work id
+// (see ../scoped_roi.h), or every row resets and dumps the stats of the sum.
+long sumRows(const std::vector<std::vector<int>> &matrix)
+{
+    M5_ROI("sum");
+    long sum = 0;
+    for (const auto &row : matrix) {
+        M5_ROI("sum/row");
+        for (int value : row) {
+            sum += value;
+        }
+    }
+    return sum;
+}
+
+int main()
+{
+    std::vector<std::vector<int>> matrix(4, std::vector<int>(256, 1));
+
+    std::cout << "Sum: " << sumRows(matrix) << std::endl;
+
+    // Regions entered from other threads carry those threads' ids.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&matrix]() {
+            m5roi::ScopedROI roi("threads");
+            sumRows(matrix);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    m5roi::printRegions();
+    return 0;
+}
@@ -0,0 +1,313 @@
+// Scoped regions of interest over gem5's m5ops.
+//
+// Marking a region by hand means picking between the instruction based ops
+// (m5_work_begin) and the address based ones (m5_work_begin_addr, which KVM
+// needs since the host CPU can't run gem5's magic instructions), mapping the
+// magic address, and keeping work ids apart. This header does all of it:
+//
+//     void kernel()
+//     {
+//         M5_ROI("kernel");
+//         for (...) {
+//             M5_ROI("kernel/inner");
+//             ...
+//         }
+//     }
+//
+// Each name gets its own work id, in the order the names are first used, and
+// the region lasts until the end of the enclosing scope. The markers nest the
+// same way, but gem5's default work begin and end handlers reset and dump all
+// of the stats, so an inner region clobbers the outer one. Nested regions,
+// like "sum/row" inside "sum" in complete/scoped-roi.cpp, need a handler that
+// counts the markers per work id, such as the ROIManager in
+// homework/cache-coherence/workloads/roi_manager.py (optionally with a
+// RoiRecorder from exercises/gem5/src/bootcamp/roi_recorder).
+// m5roi::printRegions() prints which id belongs to which name and how often
+// each region was entered.
+//
+// The ops are only compiled in when GEM5 is defined. Without it every macro
+// and class here is empty, so native builds run the kernels untouched and
+// don't need libm5.
+//
+// Which ops to use is picked the first time a region is entered. If the
+// instruction based ops work (a probe with m5_sum doesn't trap) they are
+// used, otherwise the regions are off. A trap can't tell KVM apart from real
+// hardware, where mapping M5OP_ADDR out of /dev/mem would poke at whatever
+// lives there, so the address based ops are only used when M5_ROI_MODE is
+// set to addr. They are mapped at M5OP_ADDR (0xFFFF0000 by default, override
+// with -DM5OP_ADDR=...). M5_ROI_MODE can also be set to inst or off.
+//
+// gem5 hands only the work id to the exit event handlers, the thread id is
+// just passed along with it. Give regions that have to be told apart per
+// thread their own names.
+
+#ifndef __SCOPED_ROI_H__
+#define __SCOPED_ROI_H__
+
+#include <cstdint>
+#include <cstdio>
+
+#ifdef GEM5
+
+#include <atomic>
+#include <csetjmp>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+
+#include <gem5/m5ops.h>
+#include <m5_mmap.h>
+
+#ifndef M5OP_ADDR
+#define M5OP_ADDR 0xFFFF0000
+#endif
+
+// Most distinct region names a program can use.
+#ifndef M5_ROI_MAX_REGIONS
+#define M5_ROI_MAX_REGIONS 256
+#endif
+
+namespace m5roi
+{
+
+enum class Mode
+{
+    Inst,
+    Addr,
+    Off
+};
+
+namespace detail
+{
+
+struct Region
+{
+    std::string name;
+    std::atomic<uint64_t> entries{0};
+};
+
+struct Registry
+{
+    std::mutex lock;
+    // Regions never move, so one can be used without the lock once its id
+    // is known.
+    Region regions[M5_ROI_MAX_REGIONS];
+    size_t count = 0;
+};
+
+inline Registry &
+registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+inline sigjmp_buf &
+probeJump()
+{
+    static sigjmp_buf jump;
+    return jump;
+}
+
+inline void
+onProbeTrap(int)
+{
+    siglongjmp(probeJump(), 1);
+}
+
+// Runs one harmless instruction based op. It traps (SIGILL) unless gem5 is
+// simulating the CPU.
+inline bool
+instOpsWork()
+{
+    struct sigaction action, old;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onProbeTrap;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGILL, &action, &old);
+    bool works = false;
+    if (sigsetjmp(probeJump(), 1) == 0) {
+        works = m5_sum(1, 2, 3, 4, 5, 6) == 21;
+    }
+    sigaction(SIGILL, &old, nullptr);
+    return works;
+}
+
+inline Mode
+detectMode()
+{
+    const char *forced = std::getenv("M5_ROI_MODE");
+    Mode mode;
+    if (forced != nullptr && std::strcmp(forced, "inst") == 0) {
+        mode = Mode::Inst;
+    } else if (forced != nullptr && std::strcmp(forced, "addr") == 0) {
+        mode = Mode::Addr;
+    } else if (forced != nullptr && std::strcmp(forced, "off") == 0) {
+        mode = Mode::Off;
+    } else if (instOpsWork()) {
+        mode = Mode::Inst;
+    } else {
+        mode = Mode::Off;
+    }
+
+    if (mode == Mode::Addr) {
+        // map_m5_mem() exits if it can't open the device, so check first.
+        if (access(m5_mmap_dev, R_OK | W_OK) != 0) {
+            std::fprintf(stderr, "m5roi: can't use the m5ops here (no access "
+                         "to %s), regions are off\n", m5_mmap_dev);
+            return Mode::Off;
+        }
+        m5op_addr = M5OP_ADDR;
+        map_m5_mem();
+    }
+    return mode;
+}
+
+} // namespace detail
+
+// Which ops the regions use. Picked on the first call.
+inline Mode
+mode()
+{
+    static const Mode picked = detail::detectMode();
+    return picked;
+}
+
+// The work id of the region called name, new ids counting up from 0.
+inline uint64_t
+workId(const char *name)
+{
+    detail::Registry &reg = detail::registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (size_t i = 0; i < reg.count; i++) {
+        if (reg.regions[i].name == name) {
+            return i;
+        }
+    }
+    if (reg.count == M5_ROI_MAX_REGIONS) {
+        std::fprintf(stderr, "m5roi: more than %d regions, raise "
+                     "M5_ROI_MAX_REGIONS\n", M5_ROI_MAX_REGIONS);
+        std::abort();
+    }
+    reg.regions[reg.count].name = name;
+    return reg.count++;
+}
+
+// A small id for the calling thread, in the order threads first ask.
+inline uint64_t
+threadId()
+{
+    static std::atomic<uint64_t> next{0};
+    thread_local uint64_t id = next.fetch_add(1);
+    return id;
+}
+
+inline void
+begin(uint64_t workid, uint64_t threadid)
+{
+    detail::registry().regions[workid].entries.fetch_add(
+        1, std::memory_order_relaxed);
+    switch (mode()) {
+      case Mode::Inst:
+        m5_work_begin(workid, threadid);
+        break;
+      case Mode::Addr:
+        m5_work_begin_addr(workid, threadid);
+        break;
+      case Mode::Off:
+        break;
+    }
+}
+
+inline void
+end(uint64_t workid, uint64_t threadid)
+{
+    switch (mode()) {
+      case Mode::Inst:
+        m5_work_end(workid, threadid);
+        break;
+      case Mode::Addr:
+        m5_work_end_addr(workid, threadid);
+        break;
+      case Mode::Off:
+        break;
+    }
+}
+
+// Prints every region's work id, name and how many times it was entered.
+inline void
+printRegions(FILE *out = stdout)
+{
+    detail::Registry &reg = detail::registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (size_t i = 0; i < reg.count; i++) {
+        std::fprintf(out, "ROI %zu %s entered %llu times\n", i,
+                     reg.regions[i].name.c_str(),
+                     (unsigned long long) reg.regions[i].entries.load());
+    }
+}
+
+// Marks the region from its construction to the end of its scope.
+class ScopedROI
+{
+  private:
+    const uint64_t workid;
+    const uint64_t threadid;
+
+  public:
+    explicit ScopedROI(uint64_t workid)
+        : workid(workid), threadid(threadId())
+    {
+        begin(workid, threadid);
+    }
+
+    // Looks the name up every time. In loops use M5_ROI, which doesn't.
+    explicit ScopedROI(const char *name) : ScopedROI(workId(name)) {}
+
+    ~ScopedROI() { end(workid, threadid); }
+
+    ScopedROI(const ScopedROI &) = delete;
+    ScopedROI &operator=(const ScopedROI &) = delete;
+};
+
+} // namespace m5roi
+
+#define M5_ROI_CAT_(a, b) a##b
+#define M5_ROI_CAT(a, b) M5_ROI_CAT_(a, b)
+
+// Marks the rest of the enclosing scope as region name. The name is looked
+// up once per call site.
+#define M5_ROI(name) \
+    static const uint64_t M5_ROI_CAT(m5RoiId, __LINE__) = \
+        m5roi::workId(name); \
+    m5roi::ScopedROI M5_ROI_CAT(m5Roi, __LINE__)(M5_ROI_CAT(m5RoiId, __LINE__))
+
+#else // !GEM5
+
+namespace m5roi
+{
+
+inline uint64_t workId(const char *) { return 0; }
+inline uint64_t threadId() { return 0; }
+inline void begin(uint64_t, uint64_t) {}
+inline void end(uint64_t, uint64_t) {}
+inline void printRegions(FILE * = stdout) {}
+
+class ScopedROI
+{
+  public:
+    explicit ScopedROI(uint64_t) {}
+    explicit ScopedROI(const char *) {}
+};
+
+} // namespace m5roi
+
+#define M5_ROI(name) do {} while (0)
+
+#endif // GEM5
+
+#endif // __SCOPED_ROI_H__
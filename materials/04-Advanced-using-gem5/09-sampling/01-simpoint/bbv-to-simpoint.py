@@ -0,0 +1,71 @@
+"""
+Converts the binary basic block vectors written by the BbvCollector SimObject
+(src/bootcamp/bbv_collector) into the text format SimPoint 3.2 reads, the
+same one the stock SimPoint probe writes:
+
+    T:{id}:{instructions} :{id}:{instructions} ...
+
+one line per interval.
+
+Usage
+-----
+
+python3 bbv-to-simpoint.py simpoint-analysis-m5out/bbv.bin.gz simpoint-analysis-m5out/simpoint.bb.gz
+
+Then run simpoint3.2-cmd.sh as usual. Both files are (de)compressed if their
+names end in .gz.
+"""
+
+import argparse
+import gzip
+
+MAGIC = b"BBV1"
+
+
+def open_file(path, mode):
+    if path.endswith(".gz"):
+        return gzip.open(path, mode)
+    return open(path, mode)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+parser = argparse.ArgumentParser(
+    description="Convert BbvCollector output to SimPoint 3.2 input."
+)
+parser.add_argument("input", help="bbv.bin.gz written by BbvCollector")
+parser.add_argument("output", help="Text basic block vectors, e.g. simpoint.bb.gz")
+args = parser.parse_args()
+
+with open_file(args.input, "rb") as f:
+    data = f.read()
+
+if data[: len(MAGIC)] != MAGIC:
+    raise SystemExit(f"{args.input} is not a BbvCollector stream")
+interval, pos = read_varint(data, len(MAGIC))
+
+intervals = 0
+with open_file(args.output, "wt") as out:
+    while pos < len(data):
+        count, pos = read_varint(data, pos)
+        fields = []
+        bb_id = 0
+        for _ in range(count):
+            delta, pos = read_varint(data, pos)
+            insts, pos = read_varint(data, pos)
+            bb_id += delta
+            fields.append(f":{bb_id}:{insts}")
+        out.write("T" + " ".join(fields) + " \n")
+        intervals += 1
+
+print(f"Converted {intervals} intervals of {interval} instructions")
@@ -30,6 +30,12 @@ Usage
 
 gem5 -re --outdir=simpoint-analysis-m5out simpoint-analysis.py
 
+With --binary-bbv the vectors are collected by the BbvCollector SimObject
+(src/bootcamp/bbv_collector) into simpoint-analysis-m5out/bbv.bin.gz, which
+is smaller and faster to write. Convert it for SimPoint with
+
+python3 bbv-to-simpoint.py simpoint-analysis-m5out/bbv.bin.gz simpoint-analysis-m5out/simpoint.bb.gz
+
 """
 
 import argparse
@@ -47,6 +53,15 @@ from gem5.utils.requires import requires
 
 requires(isa_required=ISA.X86)
 
+parser = argparse.ArgumentParser()
+parser.add_argument(
+    "--binary-bbv",
+    action="store_true",
+    help="Collect the basic block vectors with BbvCollector instead of the "
+    "stock SimPoint probe.",
+)
+args = parser.parse_args()
+
 cache_hierarchy = NoCache()
 
 memory = SingleChannelDDR3_1600(size="3GB")
@@ -57,7 +72,13 @@ processor = SimpleProcessor(
     num_cores=1,
 )
 
-processor.get_cores()[0].core.addSimPointProbe(1_000_000)
+if args.binary_bbv:
+    from m5.objects import BbvCollector
+
+    core = processor.get_cores()[0].core
+    core.bbv_collector = BbvCollector(manager=core, interval=1_000_000)
+else:
+    processor.get_cores()[0].core.addSimPointProbe(1_000_000)
 
 board = SimpleBoard(
     clk_freq="3GHz",
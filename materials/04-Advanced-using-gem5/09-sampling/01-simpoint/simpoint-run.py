@@ -30,6 +30,13 @@ Usage
 
 gem5 -re --outdir=simpoint[sid]-run simpoint-run.py --sid=[sid]
 
+With --functional-warmup the warmup interval runs on the ATOMIC CPU, whose
+accesses still fill the caches and update their replacement state, and only
+the SimPoint itself runs on O3. This needs gem5 built with
+src/bootcamp/warmup_tracker, which reports how much of each cache is warm
+when the SimPoint starts (warmup_tracker.coverage, the fraction of valid
+blocks, in the first stats dump in stats.txt).
+
 """
 
 import argparse
@@ -43,6 +50,7 @@ from gem5.components.memory import DualChannelDDR4_2400
 from gem5.simulate.exit_event import ExitEvent
 from gem5.components.processors.cpu_types import CPUTypes
 from gem5.components.processors.simple_processor import SimpleProcessor
+from gem5.components.processors.simple_switchable_processor import SimpleSwitchableProcessor
 from gem5.isas import ISA
 from gem5.utils.simpoint import SimPoint
 from gem5.simulate.simulator import Simulator
@@ -55,10 +63,34 @@ requires(isa_required=ISA.X86)
 parser = argparse.ArgumentParser()
 
 parser.add_argument("--sid", type=int, required=True)
+parser.add_argument(
+    "--functional-warmup",
+    action="store_true",
+    help="Warm up on the ATOMIC CPU and switch to O3 for the SimPoint.",
+)
 
 args = parser.parse_args()
 
-cache_hierarchy = PrivateL1PrivateL2WalkCacheHierarchy(
+
+class WarmupTrackedCacheHierarchy(PrivateL1PrivateL2WalkCacheHierarchy):
+    """
+    Adds a WarmupTracker to every L1 and L2 cache.
+    """
+
+    def incorporate_cache(self, board):
+        super().incorporate_cache(board)
+        from m5.objects import WarmupTracker
+
+        for cache in list(self.l1icaches) + list(self.l1dcaches) + list(self.l2caches):
+            cache.warmup_tracker = WarmupTracker(manager=cache)
+
+
+cache_hierarchy_class = (
+    WarmupTrackedCacheHierarchy
+    if args.functional_warmup
+    else PrivateL1PrivateL2WalkCacheHierarchy
+)
+cache_hierarchy = cache_hierarchy_class(
     l1d_size="32kB",
     l1i_size="32kB",
     l2_size="256kB",
@@ -66,11 +98,19 @@ cache_hierarchy = PrivateL1PrivateL2WalkCacheHierarchy(
 
 memory = DualChannelDDR4_2400(size="3GB")
 
-processor = SimpleProcessor(
-    cpu_type=CPUTypes.O3,
-    isa=ISA.X86,
-    num_cores=1,
-)
+if args.functional_warmup:
+    processor = SimpleSwitchableProcessor(
+        starting_core_type=CPUTypes.ATOMIC,
+        switch_core_type=CPUTypes.O3,
+        isa=ISA.X86,
+        num_cores=1,
+    )
+else:
+    processor = SimpleProcessor(
+        cpu_type=CPUTypes.O3,
+        isa=ISA.X86,
+        num_cores=1,
+    )
 
 board = SimpleBoard(
     clk_freq="3GHz",
@@ -101,6 +141,8 @@ def max_inst():
         else:
             print("end of warmup, starting to simulate SimPoint")
             warmed_up = True
+            if args.functional_warmup:
+                processor.switch()
             # Schedule a MAX_INSTS exit event during the simulation
             simulator.schedule_max_insts(
                 board.get_simpoint().get_simpoint_interval()
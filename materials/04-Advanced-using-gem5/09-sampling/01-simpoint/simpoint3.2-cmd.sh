@@ -1,3 +1,7 @@
 /workspaces/2024/materials/02-Using-gem5/09-sampling/01-simpoint/simpoint \
     -inputVectorsGzipped -loadFVFile simpoint-analysis-m5out/simpoint.bb.gz -k 5 -saveSimpoints \
     results.simpts -saveSimpointWeights results.weights
+
+# If the vectors came from BbvCollector (simpoint-analysis.py --binary-bbv),
+# convert them first:
+# python3 bbv-to-simpoint.py simpoint-analysis-m5out/bbv.bin.gz simpoint-analysis-m5out/simpoint.bb.gz
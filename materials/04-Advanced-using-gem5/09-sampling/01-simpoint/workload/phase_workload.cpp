@@ -0,0 +1,388 @@
+// A synthetic workload made of distinct phases, for checking how well
+// SimPoint (or SMARTS) picks up phase behavior. Each phase runs for about
+// the given number of instructions:
+//
+//   stream  streams through arrays much larger than the caches
+//   chase   chases pointers through a random cycle much larger than the caches
+//   fp      compute-bound floating point on registers
+//   branch  data-dependent, unpredictable branches
+//   simd    vector multiply-adds on arrays that fit in the L1
+//
+// Usage: phase_workload [--repeat N] [--calibrate] [{phase}:{instructions} ...]
+// Instructions can end in k, M or G. The default schedule is
+// stream:20M chase:10M fp:20M branch:10M simd:20M, run twice.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Elements in each of the streamed arrays, 3 x 32 MiB of doubles.
+#define STREAM_LENGTH (4UL << 20)
+// Nodes in the pointer chasing cycle, 32 MiB of cache blocks.
+#define CHASE_NODES (512UL << 10)
+// Floats in each of the SIMD arrays, 2 x 8 KiB.
+#define SIMD_LENGTH 2048
+// Bytes of random data the branchy phase decides on.
+#define BRANCH_LENGTH (64UL << 10)
+
+// Instructions in one iteration of each phase's loop, counted in the X86 code
+// that g++ 12 -O2 generates (objdump -d phase_workload). Recount them when a
+// loop body changes. Run with --calibrate on your machine (natively) and
+// override these with -D if your compiler or ISA differs.
+#ifndef STREAM_INSTS_PER_ITER
+#define STREAM_INSTS_PER_ITER 9
+#endif
+#ifndef CHASE_INSTS_PER_ITER
+#define CHASE_INSTS_PER_ITER 4
+#endif
+#ifndef FP_INSTS_PER_ITER
+#define FP_INSTS_PER_ITER 11
+#endif
+#ifndef BRANCH_INSTS_PER_ITER
+#define BRANCH_INSTS_PER_ITER 8
+#endif
+#ifndef SIMD_INSTS_PER_ITER
+#define SIMD_INSTS_PER_ITER 11
+#endif
+
+struct Node
+{
+    Node *next;
+    uint64_t pad[7];
+};
+
+struct State
+{
+    double *a;
+    double *b;
+    double *c;
+    size_t streamPos;
+    Node *nodes;
+    Node *chasePos;
+    uint8_t *branchData;
+    size_t branchPos;
+    float *x;
+    float *y;
+    uint64_t checksum;
+};
+
+// a = b + 3 * c, wrapping around at the end of the arrays.
+__attribute__((noinline)) void
+stream(State &s, uint64_t iters)
+{
+    double *a = s.a;
+    const double *b = s.b;
+    const double *c = s.c;
+    size_t pos = s.streamPos;
+    for (uint64_t i = 0; i < iters; i++) {
+        a[pos] = b[pos] + 3.0 * c[pos];
+        pos = (pos + 1) & (STREAM_LENGTH - 1);
+    }
+    s.streamPos = pos;
+    s.checksum += (uint64_t) a[pos];
+}
+
+__attribute__((noinline)) void
+chase(State &s, uint64_t iters)
+{
+    Node *node = s.chasePos;
+    for (uint64_t i = 0; i < iters; i++) {
+        node = node->next;
+    }
+    s.chasePos = node;
+    s.checksum += node - s.nodes;
+}
+
+// Four independent multiply-add chains so that the FP units, not the
+// latency of one chain, are the limit.
+__attribute__((noinline)) void
+fp(State &s, uint64_t iters)
+{
+    double x0 = 1.0, x1 = 2.0, x2 = 3.0, x3 = 4.0;
+    for (uint64_t i = 0; i < iters; i++) {
+        x0 = x0 * 0.999999 + 0.5;
+        x1 = x1 * 0.999998 + 0.25;
+        x2 = x2 * 0.999997 + 0.125;
+        x3 = x3 * 0.999996 + 0.0625;
+    }
+    s.checksum += (uint64_t) (x0 + x1 + x2 + x3);
+}
+
+// Taken or not taken depending on random bits, so the predictor is wrong
+// about half the time. The empty asm keeps the compiler from turning the
+// branch into a conditional move.
+__attribute__((noinline)) void
+branch(State &s, uint64_t iters)
+{
+    const uint8_t *data = s.branchData;
+    size_t pos = s.branchPos;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        if (data[pos] & 1) {
+            sum += pos;
+            asm volatile("");
+        } else {
+            sum ^= i;
+        }
+        pos = (pos + 1) & (BRANCH_LENGTH - 1);
+    }
+    s.branchPos = pos;
+    s.checksum += sum;
+}
+
+// y += 1.5 * x over the arrays again and again, one vector per iteration.
+__attribute__((noinline)) void
+simd(State &s, uint64_t iters)
+{
+    const float *x = s.x;
+    float *y = s.y;
+    size_t pos = 0;
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps(1.5f);
+    for (uint64_t i = 0; i < iters; i++) {
+        __m256 v = _mm256_loadu_ps(&y[pos]);
+        v = _mm256_add_ps(v, _mm256_mul_ps(scale, _mm256_loadu_ps(&x[pos])));
+        _mm256_storeu_ps(&y[pos], v);
+        pos = (pos + 8) & (SIMD_LENGTH - 1);
+    }
+#elif defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(1.5f);
+    for (uint64_t i = 0; i < iters; i++) {
+        __m128 v = _mm_loadu_ps(&y[pos]);
+        v = _mm_add_ps(v, _mm_mul_ps(scale, _mm_loadu_ps(&x[pos])));
+        _mm_storeu_ps(&y[pos], v);
+        pos = (pos + 4) & (SIMD_LENGTH - 1);
+    }
+#elif defined(__ARM_NEON)
+    for (uint64_t i = 0; i < iters; i++) {
+        float32x4_t v = vld1q_f32(&y[pos]);
+        v = vmlaq_n_f32(v, vld1q_f32(&x[pos]), 1.5f);
+        vst1q_f32(&y[pos], v);
+        pos = (pos + 4) & (SIMD_LENGTH - 1);
+    }
+#else
+    for (uint64_t i = 0; i < iters; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            y[pos + j] += 1.5f * x[pos + j];
+        }
+        pos = (pos + 4) & (SIMD_LENGTH - 1);
+    }
+#endif
+    s.checksum += (uint64_t) y[0];
+}
+
+struct PhaseType
+{
+    const char *name;
+    void (*run)(State &, uint64_t);
+    uint64_t instsPerIter;
+};
+
+static const PhaseType phaseTypes[] = {
+    {"stream", stream, STREAM_INSTS_PER_ITER},
+    {"chase", chase, CHASE_INSTS_PER_ITER},
+    {"fp", fp, FP_INSTS_PER_ITER},
+    {"branch", branch, BRANCH_INSTS_PER_ITER},
+    {"simd", simd, SIMD_INSTS_PER_ITER},
+};
+
+struct Phase
+{
+    const PhaseType *type;
+    uint64_t insts;
+};
+
+static uint64_t
+nextRandom(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static void
+init(State &s)
+{
+    s.a = new double[STREAM_LENGTH];
+    s.b = new double[STREAM_LENGTH];
+    s.c = new double[STREAM_LENGTH];
+    for (size_t i = 0; i < STREAM_LENGTH; i++) {
+        s.a[i] = 0;
+        s.b[i] = i;
+        s.c[i] = i % 7;
+    }
+    s.streamPos = 0;
+
+    // Link the nodes into one random cycle (Sattolo's algorithm) so that
+    // every load misses and the prefetchers can't follow it.
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+    std::vector<size_t> order(CHASE_NODES);
+    for (size_t i = 0; i < CHASE_NODES; i++) {
+        order[i] = i;
+    }
+    for (size_t i = CHASE_NODES - 1; i > 0; i--) {
+        size_t j = nextRandom(rng) % i;
+        std::swap(order[i], order[j]);
+    }
+    s.nodes = new Node[CHASE_NODES];
+    for (size_t i = 0; i < CHASE_NODES; i++) {
+        s.nodes[order[i]].next = &s.nodes[order[(i + 1) % CHASE_NODES]];
+    }
+    s.chasePos = &s.nodes[0];
+
+    s.branchData = new uint8_t[BRANCH_LENGTH];
+    for (size_t i = 0; i < BRANCH_LENGTH; i++) {
+        s.branchData[i] = nextRandom(rng);
+    }
+    s.branchPos = 0;
+
+    s.x = new float[SIMD_LENGTH];
+    s.y = new float[SIMD_LENGTH];
+    for (size_t i = 0; i < SIMD_LENGTH; i++) {
+        s.x[i] = i % 13;
+        s.y[i] = 0;
+    }
+    s.checksum = 0;
+}
+
+static bool
+parseCount(const char *text, uint64_t &count)
+{
+    char *end;
+    count = strtoull(text, &end, 10);
+    switch (*end) {
+      case 'k': count *= 1000; end++; break;
+      case 'M': count *= 1000000; end++; break;
+      case 'G': count *= 1000000000; end++; break;
+    }
+    return *end == '\0' && count > 0;
+}
+
+static bool
+parsePhase(const char *text, Phase &phase)
+{
+    const char *colon = strchr(text, ':');
+    if (colon == nullptr) {
+        return false;
+    }
+    std::string name(text, colon - text);
+    for (const auto &type: phaseTypes) {
+        if (name == type.name) {
+            phase.type = &type;
+            return parseCount(colon + 1, phase.insts);
+        }
+    }
+    return false;
+}
+
+// Counts the user level instructions of one million iterations of every
+// phase with the hardware performance counters.
+static int
+calibrate(State &s)
+{
+#if defined(__linux__)
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) {
+        printf("Could not open the instruction counter\n");
+        return 1;
+    }
+    const uint64_t iters = 1000000;
+    for (const auto &type: phaseTypes) {
+        uint64_t before, after;
+        if (read(fd, &before, sizeof(before)) != sizeof(before)) {
+            return 1;
+        }
+        type.run(s, iters);
+        if (read(fd, &after, sizeof(after)) != sizeof(after)) {
+            return 1;
+        }
+        printf("%s: %.2f instructions per iteration (using %lu)\n", type.name,
+               (double) (after - before) / iters, (unsigned long) type.instsPerIter);
+    }
+    close(fd);
+    return 0;
+#else
+    printf("Calibrating needs Linux's perf_event_open\n");
+    return 1;
+#endif
+}
+
+int
+main(int argc, char *argv[])
+{
+    std::vector<Phase> schedule;
+    uint64_t repeat = 0;
+    bool calibrating = false;
+    for (int i = 1; i < argc; i++) {
+        Phase phase;
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            if (!parseCount(argv[++i], repeat)) {
+                printf("Bad repeat count %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibrating = true;
+        } else if (parsePhase(argv[i], phase)) {
+            schedule.push_back(phase);
+        } else {
+            printf("Usage: %s [--repeat N] [--calibrate] [{phase}:{instructions} ...]\n", argv[0]);
+            printf("Phases: stream, chase, fp, branch, simd. Instructions can end in k, M or G.\n");
+            return 1;
+        }
+    }
+    if (schedule.empty()) {
+        for (const char *phase: {"stream:20M", "chase:10M", "fp:20M", "branch:10M", "simd:20M"}) {
+            schedule.push_back(Phase());
+            parsePhase(phase, schedule.back());
+        }
+        if (repeat == 0) {
+            repeat = 2;
+        }
+    }
+    if (repeat == 0) {
+        repeat = 1;
+    }
+
+    State s;
+    init(s);
+
+    if (calibrating) {
+        return calibrate(s);
+    }
+
+    for (uint64_t r = 0; r < repeat; r++) {
+        for (const auto &phase: schedule) {
+            printf("Phase %s for %lu instructions\n", phase.type->name, (unsigned long) phase.insts);
+            phase.type->run(s, phase.insts / phase.type->instsPerIter);
+        }
+    }
+
+    printf("Checksum: %lu\n", (unsigned long) s.checksum);
+
+    return 0;
+}
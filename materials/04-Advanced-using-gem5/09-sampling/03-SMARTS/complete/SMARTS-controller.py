@@ -0,0 +1,161 @@
+# Copyright (c) 2024 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Usage
+-----
+
+gem5 -re SMARTS-controller.py
+
+Runs the same sampling as SMARTS.py, but with the SmartsController SimObject
+(src/bootcamp/smarts_controller) deciding when each phase ends. It keeps a
+running mean and variance of the samples' IPC and ends the simulation once
+the confidence interval is within --target-error of the mean, so there is
+no need to know the program length or to post-process stats.txt with
+predict_ipc.py. The estimate is in the smarts_controller stats and printed
+at the end.
+
+"""
+
+import argparse
+from pathlib import Path
+
+import m5
+from m5.objects import SmartsController
+
+from gem5.components.boards.mem_mode import MemMode
+from gem5.components.boards.simple_board import SimpleBoard
+from gem5.components.cachehierarchies.classic.private_l1_private_l2_walk_cache_hierarchy import (
+    PrivateL1PrivateL2WalkCacheHierarchy,
+)
+from gem5.components.memory import DualChannelDDR4_2400
+from gem5.components.processors.cpu_types import CPUTypes
+from gem5.components.processors.simple_core import SimpleCore
+from gem5.components.processors.switchable_processor import SwitchableProcessor
+from gem5.isas import ISA
+from gem5.simulate.exit_event import ExitEvent
+from gem5.simulate.simulator import Simulator
+from gem5.resources.resource import BinaryResource
+from gem5.utils.requires import requires
+
+requires(isa_required=ISA.X86)
+
+parser = argparse.ArgumentParser()
+parser.add_argument("--k", type=int, default=183, help="Sampling period, in units.")
+parser.add_argument("--U", type=int, default=1000, help="Sampling unit size.")
+parser.add_argument("--W", type=int, default=2000, help="Detailed warmup length.")
+parser.add_argument(
+    "--confidence", type=float, default=0.997, help="Confidence of the interval."
+)
+parser.add_argument(
+    "--target-error",
+    type=float,
+    default=0.03,
+    help="Stop once the interval is within this fraction of the mean IPC.",
+)
+parser.add_argument(
+    "--min-samples", type=int, default=30, help="Samples before checking."
+)
+args = parser.parse_args()
+
+cache_hierarchy = PrivateL1PrivateL2WalkCacheHierarchy(
+    l1d_size="32kB",
+    l1i_size="32kB",
+    l2_size="256kB",
+)
+
+memory = DualChannelDDR4_2400(size="3GB")
+
+
+# Build the cores here so that they can be handed to the SmartsController.
+functional_core = SimpleCore(cpu_type=CPUTypes.ATOMIC, core_id=0, isa=ISA.X86)
+detailed_core = SimpleCore(cpu_type=CPUTypes.O3, core_id=0, isa=ISA.X86)
+
+processor = SwitchableProcessor(
+    switchable_cores={"functional": [functional_core], "detailed": [detailed_core]},
+    starting_cores="functional",
+)
+
+board = SimpleBoard(
+    clk_freq="3GHz",
+    processor=processor,
+    memory=memory,
+    cache_hierarchy=cache_hierarchy,
+)
+# SwitchableProcessor leaves the memory mode to us. Start in atomic mode for
+# the functional core, switching cores changes it from then on.
+board.set_mem_mode(MemMode.ATOMIC)
+
+board.set_se_binary_workload(
+    binary=BinaryResource(local_path=Path("/workspaces/2024/materials/02-Using-gem5/09-sampling/01-simpoint/workload/simple_workload").as_posix())
+)
+
+board.smarts_controller = SmartsController(
+    functional_cpu=functional_core.get_simobject(),
+    detailed_cpu=detailed_core.get_simobject(),
+    period=args.k,
+    unit_size=args.U,
+    detailed_warmup=args.W,
+    confidence=args.confidence,
+    target_error=args.target_error,
+    min_samples=args.min_samples,
+)
+
+
+def smarts_controller_generator(controller, processor):
+    """
+    The controller decides what runs next, this only switches the cores,
+    which has to be done from Python. The first exit, after the first
+    instruction, starts the first functional warming.
+    """
+    on_detailed = False
+    controller.startPhase()
+    yield False
+    while True:
+        controller.nextPhase()
+        if controller.done():
+            m5.stats.dump()
+            yield True
+        if controller.usesDetailedCPU() != on_detailed:
+            on_detailed = not on_detailed
+            processor.switch_to_processor("detailed" if on_detailed else "functional")
+        controller.startPhase()
+        yield False
+
+
+simulator = Simulator(
+    board=board,
+    on_exit_event={
+        ExitEvent.SIMPOINT_BEGIN: smarts_controller_generator(
+            board.smarts_controller, processor
+        )
+    },
+)
+
+processor.get_cores()[0]._set_simpoint([1], False)
+simulator.run()
+
+print("Simulation Done")